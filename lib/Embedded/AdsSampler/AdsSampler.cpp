@@ -0,0 +1,118 @@
+#include "AdsSampler.h"
+
+AdsSampler::AdsSampler(ADS1115 &ads) : _ads(ads)
+{
+}
+
+/**
+ * Configure ADS1115 conversion ready and start sampling, call after ADS1115 begin and gain are set
+ *
+ * @param[in]   alertPin    pin connected into ALERT/RDY, open drain active low
+ * @param[in]   dataRate    ADS1115 data rate code
+ *
+ * @return  true if ADS1115 is connected
+ */
+bool AdsSampler::begin(uint8_t alertPin, uint8_t dataRate)
+{
+    if (!_ads.isConnected())
+    {
+        ESP_LOGE(_TAG, "ADS1115 is not connected\n");
+        return false;
+    }
+    _alertPin = alertPin;
+    _ads.setMode(1); //single shot, the multiplexer is changed on every trigger
+    _ads.setDataRate(dataRate);
+    //high threshold MSB set and low threshold MSB clear turn ALERT into conversion ready
+    _ads.setComparatorThresholdHigh(0x8000);
+    _ads.setComparatorThresholdLow(0x0000);
+    _ads.setComparatorPolarity(0); //active low
+    _ads.setComparatorQueConvert(0); //assert after single conversion
+
+    pinMode(_alertPin, INPUT_PULLUP);
+    xTaskCreate(&AdsSampler::sampleTask, "ads sample task", 2048, this, 8, &_taskHandle);
+    attachInterruptArg(_alertPin, &AdsSampler::onReady, this, FALLING);
+    return true;
+}
+
+/**
+ * ALERT/RDY interrupt, wake the sample task
+ *
+ * @param[in]   arg pointer to AdsSampler object
+ */
+void IRAM_ATTR AdsSampler::onReady(void *arg)
+{
+    AdsSampler *sampler = static_cast<AdsSampler*>(arg);
+    BaseType_t isWoken = pdFALSE;
+    vTaskNotifyGiveFromISR(sampler->_taskHandle, &isWoken);
+    if (isWoken)
+    {
+        portYIELD_FROM_ISR();
+    }
+}
+
+/**
+ * Task to trigger conversion and read the result when ready, rotate over every channel
+ *
+ * @param[in]   pvParameter pointer to AdsSampler object
+ */
+void AdsSampler::sampleTask(void *pvParameter)
+{
+    AdsSampler *sampler = static_cast<AdsSampler*>(pvParameter);
+    uint8_t channel = 0;
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, 0); //drop stale notification
+        sampler->_ads.requestADC(channel);
+        if (!ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ADSS_READY_TIMEOUT)))
+        {
+            sampler->_timeout++; //missed edge or I2C error, trigger again
+            continue;
+        }
+        sampler->_set.raw[channel] = sampler->_ads.getValue();
+        sampler->_set.timestamp[channel] = micros();
+        channel++;
+        if (channel >= ADSS_CHANNEL)
+        {
+            channel = 0;
+            sampler->_latest.post(sampler->_set);
+        }
+    }
+}
+
+/**
+ * Read latest set
+ *
+ * @param[out]  set latest conversion of every channel
+ *
+ * @return  set sequence, 0 if no set is published yet
+ */
+uint32_t AdsSampler::read(VoltageSense::sample_set_t &set)
+{
+    return _latest.read(set);
+}
+
+/**
+ * Check if acquisition is stalled
+ *
+ * @param[in]   maxAge  maximum age of the latest set in us
+ *
+ * @return  true if no set is posted within maxAge, e.g. I2C bus is stalled
+ */
+bool AdsSampler::isStale(uint32_t maxAge)
+{
+    return _latest.isStale(maxAge);
+}
+
+/**
+ * Get number of conversion which never signal ready
+ *
+ * @return  timeout counter
+ */
+uint32_t AdsSampler::getTimeout()
+{
+    return _timeout;
+}
+
+AdsSampler::~AdsSampler()
+{
+}
@@ -0,0 +1,53 @@
+#ifndef ADS_SAMPLER_H
+#define ADS_SAMPLER_H
+
+#include <Arduino.h>
+#include <array>
+#include <ADS1X15.h>
+#include <SeqLock.h>
+#include <freertos/FreeRTOS.h>
+
+#define ADSS_CHANNEL 4 //number of single ended channel
+#define ADSS_DATA_RATE 7 //ADS1115 data rate code, 7 is 860 SPS
+#define ADSS_READY_TIMEOUT 10 //maximum wait for conversion ready in ms, conversion is restarted after timeout
+
+namespace VoltageSense {
+    /**
+     * latest conversion of every channel
+     */
+    struct sample_set_t {
+        std::array<int16_t, ADSS_CHANNEL> raw = {}; //raw ADC count
+        std::array<uint32_t, ADSS_CHANNEL> timestamp = {}; //time of conversion ready in us
+    };
+};
+
+/**
+ * Asynchronous ADS1115 acquisition
+ *
+ * @brief   single shot conversion is triggered on one channel, ALERT/RDY pin is configured as conversion ready and
+ *          its falling edge wake the sample task, which read the result and trigger the next channel. the task sleep
+ *          while the ADS1115 convert instead of polling I2C, the set of every channel is posted into a mailbox
+ */
+class AdsSampler
+{
+private:
+    /* data */
+    const char* _TAG = "ads-sampler";
+    ADS1115 &_ads;
+    uint8_t _alertPin = 0;
+    TaskHandle_t _taskHandle = NULL;
+    VoltageSense::sample_set_t _set;
+    SampleMailbox<VoltageSense::sample_set_t> _latest;
+    uint32_t _timeout = 0;
+    static void IRAM_ATTR onReady(void *arg); //ALERT/RDY interrupt
+    static void sampleTask(void *pvParameter); //trigger and read conversion
+public:
+    AdsSampler(ADS1115 &ads);
+    bool begin(uint8_t alertPin, uint8_t dataRate = ADSS_DATA_RATE); //configure ADS1115 and start sampling
+    uint32_t read(VoltageSense::sample_set_t &set); //read latest set, return its sequence
+    bool isStale(uint32_t maxAge); //check if no set is posted within maxAge us
+    uint32_t getTimeout(); //get number of conversion which never signal ready
+    ~AdsSampler();
+};
+
+#endif
@@ -0,0 +1,235 @@
+#include "CalibrationTable.h"
+
+CalibrationTable::CalibrationTable()
+{
+}
+
+/**
+ * Validate point order and compute slope of every segment
+ *
+ * @return  false if measured value is not strictly increasing
+ */
+bool CalibrationTable::build()
+{
+    if (_size > CT_MAX_POINT)
+    {
+        return false;
+    }
+    for (size_t i = 0; i + 1 < _size; i++)
+    {
+        int32_t span = (int32_t)_measured[i + 1] - _measured[i];
+        if (span <= 0)
+        {
+            return false;
+        }
+        int64_t slope = ((int64_t)((int32_t)_reference[i + 1] - _reference[i]) << CT_SLOPE_SHIFT) / span;
+        _slope[i] = slope > INT32_MAX ? INT32_MAX : (slope < INT32_MIN ? INT32_MIN : slope);
+    }
+    return true;
+}
+
+/**
+ * Calibrate value
+ *
+ * @param[in]   value   measured value
+ *
+ * @return  calibrated value, saturated into int16_t
+ */
+int16_t CalibrationTable::apply(int16_t value) const
+{
+    if (_size == 0)
+    {
+        return value;
+    }
+    if (_size == 1)
+    {
+        int32_t shifted = (int32_t)value + _reference[0] - _measured[0];
+        return shifted > INT16_MAX ? INT16_MAX : (shifted < INT16_MIN ? INT16_MIN : shifted);
+    }
+
+    //upper bound over the inner point, segment start at the point before it so value outside the table
+    //extend the first or last segment
+    size_t low = 1;
+    size_t high = _size - 1;
+    while (low < high)
+    {
+        size_t mid = (low + high) / 2;
+        if (_measured[mid] <= value)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    size_t segment = low - 1;
+
+    int64_t result = _reference[segment] + ((((int64_t)value - _measured[segment]) * _slope[segment] + (1 << (CT_SLOPE_SHIFT - 1))) >> CT_SLOPE_SHIFT);
+    return result > INT16_MAX ? INT16_MAX : (result < INT16_MIN ? INT16_MIN : result);
+}
+
+/**
+ * Add point, point with the same measured value is replaced
+ *
+ * @param[in]   measured    measured value
+ * @param[in]   reference   reference value at the same time
+ *
+ * @return  false if the table is full
+ */
+bool CalibrationTable::insert(int16_t measured, int16_t reference)
+{
+    size_t position = 0;
+    while (position < _size && _measured[position] < measured)
+    {
+        position++;
+    }
+    if (position < _size && _measured[position] == measured)
+    {
+        _reference[position] = reference;
+        return build();
+    }
+    if (_size >= CT_MAX_POINT)
+    {
+        return false;
+    }
+    for (size_t i = _size; i > position; i--)
+    {
+        _measured[i] = _measured[i - 1];
+        _reference[i] = _reference[i - 1];
+    }
+    _measured[position] = measured;
+    _reference[position] = reference;
+    _size++;
+    return build();
+}
+
+/**
+ * Remove every point
+ */
+void CalibrationTable::clear()
+{
+    _size = 0;
+}
+
+/**
+ * Get number of point
+ *
+ * @return  number of point
+ */
+uint8_t CalibrationTable::getSize() const
+{
+    return _size;
+}
+
+/**
+ * Copy table register, number of point followed by measured and reference of each point
+ *
+ * @param[in]   index   first register index
+ * @param[in]   count   number of register
+ * @param[out]  buff    register buffer
+ *
+ * @return  false if range is outside the table
+ */
+bool CalibrationTable::readRegister(uint16_t index, uint16_t count, uint16_t *buff) const
+{
+    if (index + count > CT_REGISTER_SIZE)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t reg = index + i;
+        if (reg == 0)
+        {
+            buff[i] = _size;
+            continue;
+        }
+        size_t point = (reg - 1) / 2;
+        buff[i] = (reg - 1) % 2 ? _reference[point] : _measured[point];
+    }
+    return true;
+}
+
+/**
+ * Write table register, the table is unchanged if the result is not valid. write the number of point and every
+ * point in single request when the order of point is changed
+ *
+ * @param[in]   index   first register index
+ * @param[in]   count   number of register
+ * @param[in]   buff    register buffer
+ *
+ * @return  false if range is outside the table, number of point is above CT_MAX_POINT or point is not sorted
+ */
+bool CalibrationTable::writeRegister(uint16_t index, uint16_t count, const uint16_t *buff)
+{
+    if (index + count > CT_REGISTER_SIZE)
+    {
+        return false;
+    }
+    CalibrationTable table = *this;
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t reg = index + i;
+        if (reg == 0)
+        {
+            if (buff[i] > CT_MAX_POINT)
+            {
+                return false;
+            }
+            table._size = buff[i];
+            continue;
+        }
+        size_t point = (reg - 1) / 2;
+        if ((reg - 1) % 2)
+        {
+            table._reference[point] = buff[i];
+        }
+        else
+        {
+            table._measured[point] = buff[i];
+        }
+    }
+    if (!table.build())
+    {
+        return false;
+    }
+    *this = table;
+    return true;
+}
+
+/**
+ * Restore table from flash
+ *
+ * @param[in]   preferences opened preferences
+ * @param[in]   key key of the table
+ *
+ * @return  false if nothing is stored or stored table is not valid
+ */
+bool CalibrationTable::load(Preferences &preferences, const char* key)
+{
+    uint16_t regs[CT_REGISTER_SIZE];
+    if (preferences.getBytesLength(key) != sizeof(regs))
+    {
+        return false;
+    }
+    preferences.getBytes(key, regs, sizeof(regs));
+    return writeRegister(0, CT_REGISTER_SIZE, regs);
+}
+
+/**
+ * Save table into flash
+ *
+ * @param[in]   preferences opened preferences
+ * @param[in]   key key of the table
+ */
+void CalibrationTable::save(Preferences &preferences, const char* key) const
+{
+    uint16_t regs[CT_REGISTER_SIZE];
+    readRegister(0, CT_REGISTER_SIZE, regs);
+    preferences.putBytes(key, regs, sizeof(regs));
+}
+
+CalibrationTable::~CalibrationTable()
+{
+}
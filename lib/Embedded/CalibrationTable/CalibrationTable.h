@@ -0,0 +1,42 @@
+#ifndef CALIBRATION_TABLE_H
+#define CALIBRATION_TABLE_H
+
+#include <Arduino.h>
+#include <array>
+#include <Preferences.h>
+
+#define CT_MAX_POINT 8 //maximum calibration point of single table
+#define CT_SLOPE_SHIFT 16 //fraction bit of segment slope
+#define CT_REGISTER_SIZE (1 + CT_MAX_POINT * 2) //number of point followed by measured and reference of each point
+
+/**
+ * Piecewise linear calibration table of single channel
+ *
+ * @brief   map measured value into reference value, both in the channel register unit (e.g. 0.01 A, 0.1 V).
+ *          point is sorted by measured value and the slope of every segment is precomputed, so apply cost one
+ *          binary search plus one multiply-add. value outside the table extend the first or last segment, single
+ *          point table shift the value and empty table return the value unchanged
+ */
+class CalibrationTable
+{
+private:
+    /* data */
+    uint8_t _size = 0;
+    std::array<int16_t, CT_MAX_POINT> _measured = {};
+    std::array<int16_t, CT_MAX_POINT> _reference = {};
+    std::array<int32_t, CT_MAX_POINT> _slope = {}; //slope of segment starting from the point, Q16, last point has none
+    bool build(); //validate point order and compute slope
+public:
+    CalibrationTable();
+    int16_t apply(int16_t value) const; //calibrate value
+    bool insert(int16_t measured, int16_t reference); //add or replace point with the same measured value
+    void clear(); //remove every point
+    uint8_t getSize() const; //get number of point
+    bool readRegister(uint16_t index, uint16_t count, uint16_t *buff) const; //copy table register
+    bool writeRegister(uint16_t index, uint16_t count, const uint16_t *buff); //write table register, rejected if point is not sorted
+    bool load(Preferences &preferences, const char* key); //restore table from flash
+    void save(Preferences &preferences, const char* key) const; //save table into flash
+    ~CalibrationTable();
+};
+
+#endif
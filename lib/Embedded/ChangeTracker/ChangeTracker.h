@@ -0,0 +1,156 @@
+#ifndef CHANGE_TRACKER_H
+#define CHANGE_TRACKER_H
+
+#include <Arduino.h>
+#include <array>
+
+namespace LoadModbus {
+    /**
+     * Change state of register array, published to modbus task
+     *
+     * @tparam  N   number of tracked register
+     */
+    template <size_t N>
+    struct change_state_t {
+        uint16_t sequence = 0; //change sequence, incremented on every update that change any register
+        std::array<uint16_t, N> changeSequence = {}; //sequence of the last reported change for each register
+
+        /**
+         * Build bitmap of register changed after given sequence
+         *
+         * @param[in]   since   last sequence known by the master
+         * @param[out]  buff    bitmap, bit i of word i / 16 is set if register i is changed
+         * @param[in]   words   number of word in buff
+         *
+         * @return  number of word written
+         */
+        size_t getBitmap(uint16_t since, uint16_t *buff, size_t words) const
+        {
+            bool isExpired = (uint16_t)(sequence - since) >= 0x8000; //too old to compare, report everything
+            for (size_t i = 0; i < words; i++)
+            {
+                buff[i] = 0;
+            }
+            for (size_t i = 0; i < N && (i >> 4) < words; i++)
+            {
+                if (isExpired || (int16_t)(changeSequence[i] - since) > 0)
+                {
+                    buff[i >> 4] |= 1 << (i & 0x0F);
+                }
+            }
+            return words < (N + 15) / 16 ? words : (N + 15) / 16;
+        }
+    };
+};
+
+/**
+ * Report by exception change tracker for register array
+ *
+ * @brief   a register is reported as changed only when it move at least its deadband from the last reported value,
+ *          the deadband is in register unit (e.g. 2 for 0.2 V on 0.1 V register). call update from single writer
+ *          and publish getState to the reader
+ *
+ * @tparam  N   number of tracked register
+ */
+template <size_t N>
+class ChangeTracker
+{
+private:
+    std::array<uint16_t, N> _deadband = {};
+    std::array<uint16_t, N> _reported = {};
+    LoadModbus::change_state_t<N> _state;
+    bool _isInit = false;
+public:
+    ChangeTracker() {}
+    void setDeadband(size_t index, uint16_t deadband); //set deadband of single register, 0 report every change
+    void setDeadband(size_t index, size_t count, uint16_t deadband); //set deadband of register range
+    bool update(const std::array<uint16_t, N> &value); //compare with last reported value, return true if sequence is incremented
+    const LoadModbus::change_state_t<N>& getState() const; //get change state
+    uint16_t getSequence() const; //get change sequence
+};
+
+/**
+ * Set deadband of single register
+ *
+ * @param[in]   index   register index
+ * @param[in]   deadband    deadband in register unit, 0xFFFF never report the register
+ */
+template <size_t N>
+void ChangeTracker<N>::setDeadband(size_t index, uint16_t deadband)
+{
+    if (index < N)
+    {
+        _deadband[index] = deadband;
+    }
+}
+
+/**
+ * Set deadband of register range
+ *
+ * @param[in]   index   first register index
+ * @param[in]   count   number of register
+ * @param[in]   deadband    deadband in register unit
+ */
+template <size_t N>
+void ChangeTracker<N>::setDeadband(size_t index, size_t count, uint16_t deadband)
+{
+    for (size_t i = index; i < index + count; i++)
+    {
+        setDeadband(i, deadband);
+    }
+}
+
+/**
+ * Update tracker with latest register value
+ *
+ * @param[in]   value   latest register value
+ *
+ * @return  true if any register is changed
+ */
+template <size_t N>
+bool ChangeTracker<N>::update(const std::array<uint16_t, N> &value)
+{
+    bool isChanged = false;
+    uint16_t next = _state.sequence + 1;
+    for (size_t i = 0; i < N; i++)
+    {
+        uint16_t diff = value[i] - _reported[i];
+        uint16_t distance = diff < 0x8000 ? diff : (uint16_t)(0 - diff); //work for signed and unsigned register
+        if (!_isInit || (_deadband[i] != 0xFFFF && distance != 0 && distance >= _deadband[i]))
+        {
+            _reported[i] = value[i];
+            _state.changeSequence[i] = next;
+            isChanged = true;
+        }
+    }
+    _isInit = true;
+    if (isChanged)
+    {
+        _state.sequence = next;
+    }
+    return isChanged;
+}
+
+/**
+ * Get change state
+ *
+ * @return  sequence and change sequence of each register
+ */
+template <size_t N>
+const LoadModbus::change_state_t<N>& ChangeTracker<N>::getState() const
+{
+    return _state;
+}
+
+/**
+ * Get change sequence
+ *
+ * @return  change sequence
+ */
+template <size_t N>
+uint16_t ChangeTracker<N>::getSequence() const
+{
+    return _state.sequence;
+}
+
+#endif
@@ -0,0 +1,291 @@
+#include "CurrentSampler.h"
+
+CurrentSampler::CurrentSampler()
+{
+    _oversample.fill(1);
+    _requestedOversample.fill(1);
+    resetBlock();
+}
+
+/**
+ * Start continuous sampling
+ *
+ * @param[in]   pin ADC1 pin of every channel, order follow the block channel index
+ *
+ * @return  true if success
+ */
+bool CurrentSampler::begin(const std::array<uint8_t, CS_CHANNEL> &pin)
+{
+    uint32_t channelMask = 0;
+    adc_digi_pattern_config_t pattern[CS_CHANNEL] = {};
+    for (size_t i = 0; i < CS_CHANNEL; i++)
+    {
+        int8_t channel = digitalPinToAnalogChannel(pin[i]);
+        if (channel < 0 || channel >= ADC1_CHANNEL_MAX) //ADC2 can not run together with wifi and dma on ADC1
+        {
+            ESP_LOGE(_TAG, "pin %d is not ADC1 pin\n", pin[i]);
+            return false;
+        }
+        _channel[i] = channel;
+        channelMask |= 1 << channel;
+        pattern[i].atten = ADC_ATTEN_DB_11;
+        pattern[i].channel = channel;
+        pattern[i].unit = 0; //ADC1
+        pattern[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+    }
+
+    esp_adc_cal_value_t calType = esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12, CS_DEFAULT_VREF, &_characteristic);
+    _isCalibrated = true;
+    ESP_LOGI(_TAG, "calibration type %d\n", calType);
+
+    adc_digi_init_config_t initConfig = {};
+    initConfig.max_store_buf_size = CS_FRAME_SIZE * 4;
+    initConfig.conv_num_each_intr = CS_FRAME_SIZE;
+    initConfig.adc1_chan_mask = channelMask;
+    initConfig.adc2_chan_mask = 0;
+    if (adc_digi_initialize(&initConfig) != ESP_OK)
+    {
+        ESP_LOGE(_TAG, "failed to initialize adc dma\n");
+        return false;
+    }
+
+    adc_digi_configuration_t digiConfig = {};
+    digiConfig.conv_limit_en = 1; //required by ESP32
+    digiConfig.conv_limit_num = 250;
+    digiConfig.pattern_num = CS_CHANNEL;
+    digiConfig.adc_pattern = pattern;
+    digiConfig.sample_freq_hz = CS_SAMPLE_RATE;
+    digiConfig.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    digiConfig.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+    if (adc_digi_controller_configure(&digiConfig) != ESP_OK || adc_digi_start() != ESP_OK)
+    {
+        ESP_LOGE(_TAG, "failed to start adc dma\n");
+        return false;
+    }
+
+    xTaskCreate(&CurrentSampler::sampleTask, "current sample task", 3072, this, 9, NULL);
+    return true;
+}
+
+/**
+ * Reset block accumulator
+ */
+void CurrentSampler::resetBlock()
+{
+    _sum.fill(0);
+    _min.fill(UINT16_MAX);
+    _max.fill(0);
+    _count.fill(0);
+}
+
+/**
+ * Convert raw value into voltage
+ *
+ * @param[in]   raw raw adc value
+ *
+ * @return  voltage in mV, raw value is returned when calibration is not available
+ */
+uint32_t CurrentSampler::toMilliVolt(uint32_t raw)
+{
+    return _isCalibrated ? esp_adc_cal_raw_to_voltage(raw, &_characteristic) : raw;
+}
+
+/**
+ * Convert raw sum into extended resolution voltage, calibration curve is interpolated between adjacent raw value
+ *
+ * @param[in]   sum sum of raw value
+ * @param[in]   count   number of raw value
+ *
+ * @return  average voltage in mV / 2^CS_FINE_BITS
+ */
+uint32_t CurrentSampler::toFineMilliVolt(uint32_t sum, uint32_t count)
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    uint32_t average = (((uint64_t)sum << CS_FINE_BITS) + count / 2) / count;
+    uint32_t raw = average >> CS_FINE_BITS;
+    uint32_t fraction = average & ((1 << CS_FINE_BITS) - 1);
+    uint32_t low = toMilliVolt(raw);
+    uint32_t high = fraction ? toMilliVolt(raw + 1) : low;
+    return (low << CS_FINE_BITS) + (high - low) * fraction;
+}
+
+/**
+ * Add raw sample, the block is published when every channel has CS_BLOCK_SIZE sample
+ *
+ * @param[in]   channel channel index (not the ADC channel)
+ * @param[in]   raw raw adc value
+ */
+void CurrentSampler::feed(size_t channel, uint16_t raw)
+{
+    if (channel >= CS_CHANNEL)
+    {
+        return;
+    }
+    _sum[channel] += raw;
+    _min[channel] = raw < _min[channel] ? raw : _min[channel];
+    _max[channel] = raw > _max[channel] ? raw : _max[channel];
+    _count[channel]++;
+
+    for (size_t i = 0; i < CS_CHANNEL; i++)
+    {
+        if (_count[i] < CS_BLOCK_SIZE)
+        {
+            return;
+        }
+    }
+
+    CurrentSense::sample_block_t block;
+    for (size_t i = 0; i < CS_CHANNEL; i++)
+    {
+        block.mean[i] = toMilliVolt(_sum[i] / _count[i]);
+        block.min[i] = toMilliVolt(_min[i]);
+        block.max[i] = toMilliVolt(_max[i]);
+        block.fine[i] = toFineMilliVolt(_sum[i], _count[i]);
+
+        if (_oversample[i] != _requestedOversample[i]) //restart history, old block may not be averaged with the new length
+        {
+            _oversample[i] = _requestedOversample[i];
+            _historySize[i] = 0;
+        }
+        _historySum[i][_historyIndex] = _sum[i];
+        _historyCount[i][_historyIndex] = _count[i];
+        _historySize[i] = _historySize[i] < _oversample[i] ? _historySize[i] + 1 : _oversample[i];
+        uint32_t sum = 0;
+        uint32_t count = 0;
+        for (size_t n = 0; n < _historySize[i]; n++)
+        {
+            size_t slot = (_historyIndex + CS_MAX_OVERSAMPLE - n) % CS_MAX_OVERSAMPLE;
+            sum += _historySum[i][slot];
+            count += _historyCount[i][slot];
+        }
+        block.oversampled[i] = toFineMilliVolt(sum, count);
+        uint8_t bits = 0;
+        while (bits < CS_FINE_BITS && (4UL << (bits * 2)) <= count) //4^n sample gain n bit
+        {
+            bits++;
+        }
+        block.extraBits[i] = bits;
+    }
+    _historyIndex = (_historyIndex + 1) % CS_MAX_OVERSAMPLE;
+    _block.post(block, micros() - CS_BLOCK_PERIOD / 2); //block represent its center time
+    resetBlock();
+}
+
+/**
+ * Task to read dma frame and feed every sample into decimation
+ *
+ * @param[in]   pvParameter pointer to CurrentSampler object
+ */
+void CurrentSampler::sampleTask(void *pvParameter)
+{
+    CurrentSampler *sampler = static_cast<CurrentSampler*>(pvParameter);
+    uint8_t frame[CS_FRAME_SIZE];
+    while (1)
+    {
+        uint32_t len = 0;
+        esp_err_t err = adc_digi_read_bytes(frame, CS_FRAME_SIZE, &len, ADC_MAX_DELAY);
+        if (err == ESP_ERR_INVALID_STATE) //dma buffer overflow, the frame is still valid
+        {
+            sampler->_overflow++;
+        }
+        else if (err != ESP_OK)
+        {
+            continue;
+        }
+
+        for (uint32_t i = 0; i + sizeof(adc_digi_output_data_t) <= len; i += sizeof(adc_digi_output_data_t))
+        {
+            const adc_digi_output_data_t *sample = reinterpret_cast<const adc_digi_output_data_t*>(frame + i);
+            for (size_t ch = 0; ch < CS_CHANNEL; ch++)
+            {
+                if (sampler->_channel[ch] == sample->type1.channel)
+                {
+                    sampler->feed(ch, sample->type1.data);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Read latest block
+ *
+ * @param[out]  block   latest block
+ *
+ * @return  block sequence, 0 if no block is published yet
+ */
+uint32_t CurrentSampler::read(CurrentSense::sample_block_t &block)
+{
+    return _block.read(block);
+}
+
+/**
+ * Read latest block and its time
+ *
+ * @param[out]  block   latest block
+ * @param[out]  timestamp   center time of the block in us
+ *
+ * @return  block sequence, 0 if no block is published yet
+ */
+uint32_t CurrentSampler::read(CurrentSense::sample_block_t &block, uint32_t &timestamp)
+{
+    return _block.read(block, timestamp);
+}
+
+/**
+ * Check if sampling is stalled
+ *
+ * @param[in]   maxAge  maximum age of the latest block in us
+ *
+ * @return  true if no block is posted within maxAge
+ */
+bool CurrentSampler::isStale(uint32_t maxAge)
+{
+    return _block.isStale(maxAge);
+}
+
+/**
+ * Get number of dma overflow
+ *
+ * @return  overflow counter
+ */
+uint32_t CurrentSampler::getOverflow()
+{
+    return _overflow;
+}
+
+/**
+ * Set oversampling, applied from the next block
+ *
+ * @param[in]   channel channel index
+ * @param[in]   block   number of recent block averaged into oversampled value (1 - CS_MAX_OVERSAMPLE), latency of
+ *                      oversampled value is half of the averaged time
+ */
+void CurrentSampler::setOversampling(size_t channel, uint8_t block)
+{
+    if (channel >= CS_CHANNEL)
+    {
+        return;
+    }
+    _requestedOversample[channel] = block < 1 ? 1 : (block > CS_MAX_OVERSAMPLE ? CS_MAX_OVERSAMPLE : block);
+}
+
+/**
+ * Get oversampling
+ *
+ * @param[in]   channel channel index
+ *
+ * @return  number of recent block averaged into oversampled value
+ */
+uint8_t CurrentSampler::getOversampling(size_t channel)
+{
+    return channel < CS_CHANNEL ? _requestedOversample[channel] : 0;
+}
+
+CurrentSampler::~CurrentSampler()
+{
+}
@@ -0,0 +1,82 @@
+#ifndef CURRENT_SAMPLER_H
+#define CURRENT_SAMPLER_H
+
+#include <Arduino.h>
+#include <array>
+#include <driver/adc.h>
+#include <esp_adc_cal.h>
+#include <SeqLock.h>
+
+#define CS_CHANNEL 3 //number of current channel
+#define CS_SAMPLE_RATE 20000 //total conversion rate in Hz, shared by every channel (ESP32 minimum is 20 kHz)
+#define CS_BLOCK_SIZE 64 //sample per channel for each block
+#define CS_BLOCK_PERIOD ((uint32_t)CS_BLOCK_SIZE * CS_CHANNEL * 1000000UL / CS_SAMPLE_RATE) //time covered by single block in us
+#define CS_FRAME_SIZE 256 //byte read from dma for each read, 2 byte per sample
+#define CS_DEFAULT_VREF 1100 //default reference voltage in mV when efuse is not burned
+#define CS_MAX_OVERSAMPLE 16 //maximum block averaged into single extended resolution value
+#define CS_FINE_BITS 5 //fraction bit of extended resolution value, 1/32 mV
+
+namespace CurrentSense {
+    /**
+     * decimated block of every channel, voltage in mV
+     */
+    struct sample_block_t {
+        std::array<uint32_t, CS_CHANNEL> mean = {}; //average voltage of the block
+        std::array<uint32_t, CS_CHANNEL> min = {}; //minimum voltage of the block
+        std::array<uint32_t, CS_CHANNEL> max = {}; //maximum voltage of the block
+        std::array<uint32_t, CS_CHANNEL> fine = {}; //average voltage of the block in mV / 2^CS_FINE_BITS, no extra latency
+        std::array<uint32_t, CS_CHANNEL> oversampled = {}; //average voltage of the last N block in mV / 2^CS_FINE_BITS
+        std::array<uint8_t, CS_CHANNEL> extraBits = {}; //effective bit of oversampled value gained over single sample
+    };
+};
+
+/**
+ * Continuous current sampling on ADC1
+ *
+ * @brief   ADC1 run in continuous (DMA) mode over every channel at CS_SAMPLE_RATE, the sample task decimate
+ *          CS_BLOCK_SIZE sample of each channel into one block and post it with its capture time into a mailbox
+ *          (timestamp is the block center), so the protection loop read the latest block without blocking and detect stalled sampling. feed can be called directly by another
+ *          backend (e.g. recorded sample) to run the same decimation.
+ *          every block is decimated without truncation into fine value, each channel also keep a moving sum of its
+ *          last N block (oversampling, 1 - CS_MAX_OVERSAMPLE) decimated into oversampled value. every 4x sample add
+ *          1 bit while the ADC noise act as dither, larger N trade latency (N block) for resolution so protection
+ *          should use fine value and telemetry the oversampled one
+ */
+class CurrentSampler
+{
+private:
+    /* data */
+    const char* _TAG = "current-sampler";
+    std::array<uint8_t, CS_CHANNEL> _channel = {};
+    esp_adc_cal_characteristics_t _characteristic;
+    bool _isCalibrated = false;
+    std::array<uint32_t, CS_CHANNEL> _sum = {};
+    std::array<uint16_t, CS_CHANNEL> _min = {};
+    std::array<uint16_t, CS_CHANNEL> _max = {};
+    std::array<uint16_t, CS_CHANNEL> _count = {};
+    uint32_t _overflow = 0;
+    std::array<uint8_t, CS_CHANNEL> _oversample = {}; //active oversampling, history is restarted when it change
+    std::array<uint8_t, CS_CHANNEL> _requestedOversample = {}; //written by setOversampling
+    std::array<std::array<uint32_t, CS_MAX_OVERSAMPLE>, CS_CHANNEL> _historySum = {}; //raw sum of recent block
+    std::array<std::array<uint16_t, CS_MAX_OVERSAMPLE>, CS_CHANNEL> _historyCount = {}; //sample count of recent block
+    std::array<uint8_t, CS_CHANNEL> _historySize = {}; //number of valid block in history
+    uint8_t _historyIndex = 0; //next history slot, shared by every channel
+    SampleMailbox<CurrentSense::sample_block_t> _block;
+    void resetBlock(); //reset accumulator
+    uint32_t toMilliVolt(uint32_t raw); //convert raw value into mV
+    uint32_t toFineMilliVolt(uint32_t sum, uint32_t count); //convert raw sum into mV / 2^CS_FINE_BITS
+    static void sampleTask(void *pvParameter); //task to read dma frame
+public:
+    CurrentSampler();
+    bool begin(const std::array<uint8_t, CS_CHANNEL> &pin); //start continuous sampling on ADC1 pin
+    void feed(size_t channel, uint16_t raw); //add raw sample of channel index
+    uint32_t read(CurrentSense::sample_block_t &block); //read latest block, return its sequence
+    uint32_t read(CurrentSense::sample_block_t &block, uint32_t &timestamp); //read latest block and its center time in us
+    bool isStale(uint32_t maxAge); //check if no block is posted within maxAge us
+    uint32_t getOverflow(); //get number of dma overflow
+    void setOversampling(size_t channel, uint8_t block); //set number of block averaged into oversampled value
+    uint8_t getOversampling(size_t channel); //get number of block averaged into oversampled value
+    ~CurrentSampler();
+};
+
+#endif
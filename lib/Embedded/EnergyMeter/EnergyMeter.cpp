@@ -0,0 +1,156 @@
+#include "EnergyMeter.h"
+
+EnergyMeter::EnergyMeter()
+{
+}
+
+/**
+ * Restore total from flash and start save task
+ *
+ * @param[in]   name    preferences namespace, must stay valid for the lifetime of the object
+ * @param[in]   saveInterval    minimum time between periodic save in ms
+ *
+ * @return  true if success
+ */
+bool EnergyMeter::begin(const char* name, uint32_t saveInterval)
+{
+    _name = name;
+    _saveInterval = saveInterval;
+    Preferences preferences;
+    preferences.begin(_name, true);
+    if (preferences.getBytesLength("total") == sizeof(_total))
+    {
+        preferences.getBytes("total", &_total, sizeof(_total));
+    }
+    preferences.end();
+
+    _saveQueue = xQueueCreate(1, sizeof(Energy::energy_total_t));
+    if (_saveQueue == NULL)
+    {
+        ESP_LOGE(_TAG, "failed to create save queue\n");
+        return false;
+    }
+    _lastSave = millis();
+    xTaskCreate(&EnergyMeter::saveTask, "energy save task", 2560, this, 3, NULL);
+    return true;
+}
+
+/**
+ * Set system voltage sag threshold, total is saved once when voltage drop below sag voltage
+ *
+ * @param[in]   sagVoltage  sag voltage in 0.1 V, 0 to disable
+ * @param[in]   recoverVoltage  voltage in 0.1 V to rearm the sag detection
+ */
+void EnergyMeter::setSagThreshold(int16_t sagVoltage, int16_t recoverVoltage)
+{
+    _sagVoltage = sagVoltage;
+    _recoverVoltage = recoverVoltage;
+}
+
+/**
+ * Integrate time aligned frame
+ *
+ * @param[in]   current current of every channel in 0.01 A
+ * @param[in]   power   power of every channel in 0.1 W
+ * @param[in]   timestamp   frame time in us, integration step is the time from previous frame
+ * @param[in]   systemVoltage   system voltage in 0.1 V, for sag detection
+ */
+void EnergyMeter::update(const std::array<int16_t, EM_CHANNEL> &current, const std::array<int16_t, EM_CHANNEL> &power, uint32_t timestamp, int16_t systemVoltage)
+{
+    if (_hasTimestamp && timestamp != _lastTimestamp)
+    {
+        uint32_t step = timestamp - _lastTimestamp;
+        if (step <= EM_MAX_STEP)
+        {
+            for (size_t i = 0; i < EM_CHANNEL; i++)
+            {
+                _total.charge[i] += (int64_t)current[i] * step;
+                _total.energy[i] += (int64_t)power[i] * step;
+            }
+            _isDirty = true;
+        }
+    }
+    _lastTimestamp = timestamp;
+    _hasTimestamp = true;
+
+    if (_sagVoltage && systemVoltage < _sagVoltage && !_isSagged)
+    {
+        _isSagged = true;
+        _isSagPending = true;
+    }
+    else if (systemVoltage > _recoverVoltage)
+    {
+        _isSagged = false;
+    }
+
+    if (_isSagPending && millis() - _lastSagSave > EM_SAG_HOLDOFF) //flickering supply does not wear the flash, sag inside holdoff is saved once it expire
+    {
+        _isSagPending = false;
+        _lastSagSave = millis();
+        ESP_LOGW(_TAG, "system voltage sag, save total\n");
+        flush();
+    }
+
+    if (_isDirty && millis() - _lastSave > _saveInterval)
+    {
+        flush();
+    }
+}
+
+/**
+ * Reset every total and save it, the reader never see partially reset total when it is published after reset
+ */
+void EnergyMeter::reset()
+{
+    _total = Energy::energy_total_t();
+    flush();
+}
+
+/**
+ * Queue total to be saved by save task, older pending total is replaced
+ */
+void EnergyMeter::flush()
+{
+    if (_saveQueue == NULL)
+    {
+        return;
+    }
+    xQueueOverwrite(_saveQueue, &_total);
+    _lastSave = millis();
+    _isDirty = false;
+}
+
+/**
+ * Task to write total into flash, keep flash write outside the control loop
+ *
+ * @param[in]   pvParameter pointer to EnergyMeter object
+ */
+void EnergyMeter::saveTask(void *pvParameter)
+{
+    EnergyMeter *meter = static_cast<EnergyMeter*>(pvParameter);
+    Energy::energy_total_t total;
+    while (1)
+    {
+        if (xQueueReceive(meter->_saveQueue, &total, portMAX_DELAY) == pdTRUE)
+        {
+            Preferences preferences;
+            preferences.begin(meter->_name);
+            preferences.putBytes("total", &total, sizeof(total));
+            preferences.end();
+        }
+    }
+}
+
+/**
+ * Get total
+ *
+ * @return  charge and energy of every channel
+ */
+const Energy::energy_total_t& EnergyMeter::getTotal() const
+{
+    return _total;
+}
+
+EnergyMeter::~EnergyMeter()
+{
+}
@@ -0,0 +1,89 @@
+#ifndef ENERGY_METER_H
+#define ENERGY_METER_H
+
+#include <Arduino.h>
+#include <array>
+#include <Preferences.h>
+#include <freertos/FreeRTOS.h>
+
+#define EM_CHANNEL 3 //number of load channel
+#define EM_MAX_STEP 1000000 //maximum integration step in us, longer gap (e.g. stalled sampling) is not integrated
+#define EM_REGISTER_DIVISOR 360000000LL //0.01 A us into mAh, and 0.1 W us into 0.01 Wh
+#define EM_SAG_HOLDOFF 10000 //minimum time between flush caused by voltage sag in ms
+#define EM_REGISTER_SIZE (EM_CHANNEL * 4) //charge and energy of each channel as 32 bit register pair
+
+namespace Energy {
+    /**
+     * accumulated charge and energy of every channel
+     */
+    struct energy_total_t {
+        std::array<int64_t, EM_CHANNEL> charge = {}; //charge in 0.01 A us
+        std::array<int64_t, EM_CHANNEL> energy = {}; //energy in 0.1 W us
+
+        /**
+         * Copy register, each channel is charge in mAh followed by energy in 0.01 Wh, 32 bit signed high word first
+         *
+         * @param[in]   index   first register index
+         * @param[in]   count   number of register
+         * @param[out]  buff    register buffer
+         *
+         * @return  false if range is outside the register
+         */
+        bool readRegister(uint16_t index, uint16_t count, uint16_t *buff) const
+        {
+            if (index + count > EM_REGISTER_SIZE)
+            {
+                return false;
+            }
+            for (size_t i = 0; i < count; i++)
+            {
+                size_t channel = (index + i) / 4;
+                size_t offset = (index + i) % 4;
+                int64_t total = offset < 2 ? charge[channel] : energy[channel];
+                uint32_t value = (uint32_t)(int32_t)(total / EM_REGISTER_DIVISOR);
+                buff[i] = offset % 2 ? value & 0xFFFF : value >> 16;
+            }
+            return true;
+        }
+    };
+};
+
+/**
+ * Per channel charge (Ah) and energy (Wh) meter
+ *
+ * @brief   current and power of time aligned frame are integrated in fixed point over the time between frame.
+ *          the total is saved into flash by background task on coalesced interval, on system voltage sag (supply is
+ *          about to fail) and on request, so the flash is written at most once per interval in normal operation.
+ *          call update, reset and flush from single writer
+ */
+class EnergyMeter
+{
+private:
+    /* data */
+    const char* _TAG = "energy-meter";
+    const char* _name = "energy";
+    Energy::energy_total_t _total;
+    uint32_t _lastTimestamp = 0;
+    bool _hasTimestamp = false;
+    uint32_t _saveInterval = 0;
+    unsigned long _lastSave = 0;
+    unsigned long _lastSagSave = 0;
+    bool _isDirty = false;
+    bool _isSagged = false;
+    bool _isSagPending = false; //sag save waiting for the holdoff
+    int16_t _sagVoltage = 0;
+    int16_t _recoverVoltage = 0;
+    QueueHandle_t _saveQueue = NULL;
+    static void saveTask(void *pvParameter); //write queued total into flash
+public:
+    EnergyMeter();
+    bool begin(const char* name, uint32_t saveInterval); //restore total from flash and start save task
+    void setSagThreshold(int16_t sagVoltage, int16_t recoverVoltage); //set system voltage sag flush threshold in 0.1 V, 0 to disable
+    void update(const std::array<int16_t, EM_CHANNEL> &current, const std::array<int16_t, EM_CHANNEL> &power, uint32_t timestamp, int16_t systemVoltage); //integrate frame
+    void reset(); //reset every total and save it
+    void flush(); //save total now
+    const Energy::energy_total_t& getTotal() const; //get total
+    ~EnergyMeter();
+};
+
+#endif
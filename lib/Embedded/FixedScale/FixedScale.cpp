@@ -0,0 +1,133 @@
+#include "FixedScale.h"
+
+FixedScale::FixedScale()
+{
+}
+
+/**
+ * Set conversion factor and offset
+ *
+ * @param[in]   factor  register unit for each raw unit
+ * @param[in]   offset  raw value converted into 0
+ *
+ * @return  false if factor does not fit into the scale
+ */
+bool FixedScale::setup(float factor, int32_t offset)
+{
+    float scale = factor * (1 << FS_SHIFT);
+    if (scale >= (float)INT32_MAX || scale <= (float)INT32_MIN)
+    {
+        return false;
+    }
+    _scale = (int32_t)lroundf(scale);
+    _offset = offset;
+    return true;
+}
+
+/**
+ * Build conversion of CC6940 output into 0.01 A, follow CC6940::getCurrent (multiplier is not applied)
+ *
+ * @param[in]   config  CC6940 config
+ * @param[in]   fractionBits    fraction bit of the input, 0 for whole mV
+ *
+ * @return  conversion from mV / 2^fractionBits into 0.01 A
+ */
+FixedScale FixedScale::fromCC6940(const CC6940Config &config, uint8_t fractionBits)
+{
+    FixedScale scale;
+    if (config.resolution)
+    {
+        scale.setup(100.0f / config.resolution / (1 << fractionBits), ((int32_t)config.midPoint + config.offset) * (1 << fractionBits));
+    }
+    return scale;
+}
+
+/**
+ * Build conversion of ADC count into 0.1 V
+ *
+ * @param[in]   voltPerCount    volt for each ADC count at active gain (e.g. ADS.toVoltage(1))
+ * @param[in]   multiplier  voltage divider ratio
+ *
+ * @return  conversion from ADC count into 0.1 V
+ */
+FixedScale FixedScale::fromVoltageFactor(float voltPerCount, float multiplier)
+{
+    FixedScale scale;
+    scale.setup(voltPerCount * multiplier * 10);
+    return scale;
+}
+
+/**
+ * Convert single sample
+ *
+ * @param[in]   raw raw sample
+ *
+ * @return  value in register unit, saturated into int16_t
+ */
+int16_t FixedScale::convert(int32_t raw) const
+{
+    int64_t value = ((int64_t)(raw - _offset) * _scale + (1 << (FS_SHIFT - 1))) >> FS_SHIFT;
+    if (value > INT16_MAX)
+    {
+        return INT16_MAX;
+    }
+    if (value < INT16_MIN)
+    {
+        return INT16_MIN;
+    }
+    return (int16_t)value;
+}
+
+/**
+ * Convert block of unsigned sample (e.g. mV from ADC1)
+ *
+ * @param[in]   raw raw sample
+ * @param[out]  out value in register unit
+ * @param[in]   count   number of sample
+ */
+void FixedScale::convert(const uint32_t *raw, int16_t *out, size_t count) const
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        out[i] = convert((int32_t)raw[i]);
+    }
+}
+
+/**
+ * Convert block of signed sample (e.g. ADS1115 count)
+ *
+ * @param[in]   raw raw sample
+ * @param[out]  out value in register unit
+ * @param[in]   count   number of sample
+ */
+void FixedScale::convert(const int16_t *raw, int16_t *out, size_t count) const
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        out[i] = convert((int32_t)raw[i]);
+    }
+}
+
+/**
+ * Get factor represented by the scale
+ *
+ * @return  register unit for each raw unit
+ */
+float FixedScale::getFactor() const
+{
+    return (float)_scale / (1 << FS_SHIFT);
+}
+
+/**
+ * Get offset
+ *
+ * @return  raw value converted into 0
+ */
+int32_t FixedScale::getOffset() const
+{
+    return _offset;
+}
+
+FixedScale::~FixedScale()
+{
+}
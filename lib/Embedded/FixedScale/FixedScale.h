@@ -0,0 +1,36 @@
+#ifndef FIXED_SCALE_H
+#define FIXED_SCALE_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <cc6940.h>
+
+#define FS_SHIFT 16 //fraction bit of the scale
+
+/**
+ * Integer fixed point conversion from raw sample into register unit
+ *
+ * @brief   output = round((raw - offset) * factor), factor is stored as scale / 2^FS_SHIFT so every sample
+ *          cost one 64 bit multiply and shift. output is saturated into int16_t register. build it once from
+ *          the sensor config, the rounding error is at most 0.5 register unit plus |raw - offset| / 2^(FS_SHIFT + 1)
+ */
+class FixedScale
+{
+private:
+    /* data */
+    int32_t _offset = 0;
+    int32_t _scale = 1 << FS_SHIFT;
+public:
+    FixedScale();
+    bool setup(float factor, int32_t offset = 0); //set factor and offset in raw unit
+    static FixedScale fromCC6940(const CC6940Config &config, uint8_t fractionBits = 0); //mV / 2^fractionBits into 0.01 A
+    static FixedScale fromVoltageFactor(float voltPerCount, float multiplier); //ADC count into 0.1 V
+    int16_t convert(int32_t raw) const; //convert single sample
+    void convert(const uint32_t *raw, int16_t *out, size_t count) const; //convert block of unsigned sample
+    void convert(const int16_t *raw, int16_t *out, size_t count) const; //convert block of signed sample
+    float getFactor() const; //get factor represented by the scale
+    int32_t getOffset() const; //get offset in raw unit
+    ~FixedScale();
+};
+
+#endif
@@ -0,0 +1,110 @@
+#include "FrameAligner.h"
+
+FrameAligner::FrameAligner()
+{
+}
+
+/**
+ * Set voltage channel used for power of load channel
+ *
+ * @param[in]   channel load channel
+ * @param[in]   voltageChannel  voltage channel measuring the same load
+ */
+void FrameAligner::setLoadVoltage(size_t channel, uint8_t voltageChannel)
+{
+    if (channel < FA_LOAD_CHANNEL && voltageChannel < FA_VOLTAGE_CHANNEL)
+    {
+        _loadVoltage[channel] = voltageChannel;
+    }
+}
+
+/**
+ * Add voltage set into history
+ *
+ * @param[in]   voltage voltage of every channel in 0.1 V
+ * @param[in]   timestamp   conversion time of every channel in us
+ * @param[in]   sequence    set sequence, set with the same sequence as the newest is ignored
+ */
+void FrameAligner::addVoltage(const std::array<int16_t, FA_VOLTAGE_CHANNEL> &voltage, const std::array<uint32_t, FA_VOLTAGE_CHANNEL> &timestamp, uint32_t sequence)
+{
+    if (sequence == 0 || (_size && sequence == _sequence))
+    {
+        return;
+    }
+    _head = (_head + 1) % FA_HISTORY;
+    _voltage[_head] = voltage;
+    _timestamp[_head] = timestamp;
+    _sequence = sequence;
+    if (_size < FA_HISTORY)
+    {
+        _size++;
+    }
+}
+
+/**
+ * Interpolate voltage of single channel
+ *
+ * @param[in]   channel voltage channel
+ * @param[in]   timestamp   time in us
+ *
+ * @return  voltage in 0.1 V
+ */
+int16_t FrameAligner::interpolate(uint8_t channel, uint32_t timestamp) const
+{
+    //walk from the newest set, find the first sample not later than timestamp
+    size_t newer = _head;
+    for (size_t n = 0; n < _size; n++)
+    {
+        size_t index = (_head + FA_HISTORY - n) % FA_HISTORY;
+        int32_t age = (int32_t)(timestamp - _timestamp[index][channel]); //positive if sample is before timestamp
+        if (age >= 0)
+        {
+            if (n == 0)
+            {
+                return _voltage[index][channel]; //later than the newest sample
+            }
+            int32_t span = (int32_t)(_timestamp[newer][channel] - _timestamp[index][channel]);
+            if (span <= 0)
+            {
+                return _voltage[index][channel];
+            }
+            int32_t delta = _voltage[newer][channel] - _voltage[index][channel];
+            return _voltage[index][channel] + (int16_t)(((int64_t)delta * age) / span);
+        }
+        newer = index;
+    }
+    return _voltage[newer][channel]; //earlier than the oldest sample
+}
+
+/**
+ * Build frame aligned into current timestamp
+ *
+ * @param[in]   current current of every load channel in 0.01 A
+ * @param[in]   timestamp   time of the current sample in us
+ * @param[out]  frame   aligned frame
+ *
+ * @return  false if no voltage set is available yet
+ */
+bool FrameAligner::align(const std::array<int16_t, FA_LOAD_CHANNEL> &current, uint32_t timestamp, PowerSense::power_frame_t &frame) const
+{
+    if (!_size)
+    {
+        return false;
+    }
+    frame.timestamp = timestamp;
+    frame.current = current;
+    for (uint8_t i = 0; i < FA_VOLTAGE_CHANNEL; i++)
+    {
+        frame.voltage[i] = interpolate(i, timestamp);
+    }
+    for (size_t i = 0; i < FA_LOAD_CHANNEL; i++)
+    {
+        int32_t power = ((int32_t)frame.voltage[_loadVoltage[i]] * current[i]) / 100; //0.1 V x 0.01 A = 0.001 W
+        frame.power[i] = power > INT16_MAX ? INT16_MAX : (power < INT16_MIN ? INT16_MIN : power);
+    }
+    return true;
+}
+
+FrameAligner::~FrameAligner()
+{
+}
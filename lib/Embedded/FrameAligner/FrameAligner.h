@@ -0,0 +1,50 @@
+#ifndef FRAME_ALIGNER_H
+#define FRAME_ALIGNER_H
+
+#include <Arduino.h>
+#include <array>
+
+#define FA_LOAD_CHANNEL 3 //number of load (current) channel
+#define FA_VOLTAGE_CHANNEL 4 //number of voltage channel
+#define FA_HISTORY 4 //voltage set kept for interpolation, cover one current block at 860 SPS
+
+namespace PowerSense {
+    /**
+     * voltage and current of every channel aligned into the same time
+     */
+    struct power_frame_t {
+        uint32_t timestamp = 0; //common time of the frame in us
+        std::array<int16_t, FA_VOLTAGE_CHANNEL> voltage = {}; //voltage in 0.1 V, interpolated into timestamp
+        std::array<int16_t, FA_LOAD_CHANNEL> current = {}; //current in 0.01 A
+        std::array<int16_t, FA_LOAD_CHANNEL> power = {}; //load voltage x load current in 0.1 W
+    };
+};
+
+/**
+ * Align voltage set into current block time and compute per channel power
+ *
+ * @brief   voltage channel are converted one after another, each with its own timestamp, while current block
+ *          represent the block center time. the last FA_HISTORY voltage set are kept and every voltage channel is
+ *          linearly interpolated into the current timestamp, so V x I use sample taken at the same time without
+ *          extra conversion. time before the oldest or after the newest set use the nearest sample
+ */
+class FrameAligner
+{
+private:
+    /* data */
+    std::array<std::array<int16_t, FA_VOLTAGE_CHANNEL>, FA_HISTORY> _voltage = {};
+    std::array<std::array<uint32_t, FA_VOLTAGE_CHANNEL>, FA_HISTORY> _timestamp = {};
+    std::array<uint8_t, FA_LOAD_CHANNEL> _loadVoltage = {0, 1, 2};
+    size_t _head = 0; //index of the newest set
+    size_t _size = 0; //number of stored set
+    uint32_t _sequence = 0; //sequence of the newest set
+    int16_t interpolate(uint8_t channel, uint32_t timestamp) const; //voltage of channel at timestamp
+public:
+    FrameAligner();
+    void setLoadVoltage(size_t channel, uint8_t voltageChannel); //set voltage channel used for power of load channel
+    void addVoltage(const std::array<int16_t, FA_VOLTAGE_CHANNEL> &voltage, const std::array<uint32_t, FA_VOLTAGE_CHANNEL> &timestamp, uint32_t sequence); //add voltage set, same sequence is ignored
+    bool align(const std::array<int16_t, FA_LOAD_CHANNEL> &current, uint32_t timestamp, PowerSense::power_frame_t &frame) const; //build aligned frame
+    ~FrameAligner();
+};
+
+#endif
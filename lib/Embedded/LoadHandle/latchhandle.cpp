@@ -133,6 +133,7 @@ void LatchHandle::handle(bool action, bool feedback)
                             return;
                         }
                         _pulseOnState = true;
+                        _failOnTotal++; //retry in fail state, count it as fail
                         Latch::latch_sync_signal_t signal; //build data to pass into callback
                         signal.id = _id;
                         signal.pulseOn = _pulseOn;
@@ -158,6 +159,10 @@ void LatchHandle::handle(bool action, bool feedback)
                         ESP_LOGI(_TAG, "relay on");
                         _onSignalCb(signal); //call the on signal callback
                     }
+                    if (_failOnCnt > 0) //previous pulse is completed and feedback still low, count it as fail
+                    {
+                        _failOnTotal++;
+                    }
                     _failOnCnt++; //because action high and feedback still low, count it as fail
                     if (_failOnCnt > _maxRetry) //if too many failed trigger, enter fail state
                     {
@@ -188,6 +193,7 @@ void LatchHandle::handle(bool action, bool feedback)
                             return;
                         }
                         _pulseOffState = true;
+                        _failOffTotal++; //retry in fail state, count it as fail
                         Latch::latch_sync_signal_t signal; //build data to pass into callback
                         signal.id = _id;
                         signal.pulseOff = _pulseOff;
@@ -214,6 +220,10 @@ void LatchHandle::handle(bool action, bool feedback)
                         ESP_LOGI(_TAG, "relay off");
                         _onSignalCb(signal); //call the on signal callback
                     }
+                    if (_failOffCnt > 0) //previous pulse is completed and feedback still high, count it as fail
+                    {
+                        _failOffTotal++;
+                    }
                     _failOffCnt++;
                     if (_failOffCnt > _maxRetry)
                     {
@@ -263,6 +273,26 @@ bool LatchHandle::isFailedOff()
     return _failOff;
 }
 
+/**
+ * Get number of failed relay ON
+ * 
+ * @return  number of relay ON pulse without feedback since boot
+ */
+uint32_t LatchHandle::getFailOnCount()
+{
+    return _failOnTotal;
+}
+
+/**
+ * Get number of failed relay OFF
+ * 
+ * @return  number of relay OFF pulse without feedback since boot
+ */
+uint32_t LatchHandle::getFailOffCount()
+{
+    return _failOffTotal;
+}
+
 LatchHandle::~LatchHandle()
 {
 }
\ No newline at end of file
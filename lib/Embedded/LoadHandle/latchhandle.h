@@ -58,6 +58,8 @@ private:
     int _failOnCnt;
     int _failOffCnt;
     int _maxRetry;
+    uint32_t _failOnTotal = 0;
+    uint32_t _failOffTotal = 0;
     bool _failOn;
     bool _failOff;
     bool _isStop;
@@ -80,6 +82,8 @@ public:
     void resetPulseOff(); //reset pulse off flag
     bool isFailedOn(); //get failed relay on
     bool isFailedOff(); //get failed relay off
+    uint32_t getFailOnCount(); //get number of failed relay on since boot
+    uint32_t getFailOffCount(); //get number of failed relay off since boot
     ~LatchHandle();
 };
 
@@ -10,13 +10,17 @@ namespace LoadModbus {
      * 
      * bit 0 : run status
      * bit 1 : mode status
-     * bit 2 - 15 : unused
+     * bit 2 : voltage sensor fault, no ADS1115 conversion within timeout
+     * bit 3 : current sensor fault, no ADC block within timeout
+     * bit 4 - 15 : unused
      */
     union SystemStatus {
         struct bitField {
             uint16_t run : 1;
             uint16_t mode : 1;
-            uint16_t : 14;
+            uint16_t voltageFault : 1;
+            uint16_t currentFault : 1;
+            uint16_t : 12;
         } flag;
         uint16_t value;
     };
@@ -57,15 +61,67 @@ namespace LoadModbus {
         uint16_t value;
     };
     
-    struct modbusRegister
+    typedef std::array<uint16_t, 12> inputRegisterArray; //input register, published as one snapshot per loop
+
+    /**
+     * Group command, written into group command register of the target group
+     */
+    enum GroupCommand : uint16_t {
+        GROUP_NONE = 0,
+        GROUP_MANUAL = 1, //switch into manual mode
+        GROUP_AUTO = 2, //switch back into auto mode
+        GROUP_SHED = 3, //manual mode and pulse every relay OFF
+        GROUP_RECONNECT = 4 //manual mode and pulse every relay ON
+    };
+
+    /**
+     * Extended telemetry register index
+     * 
+     * all telemetry, status and counter packed into one contiguous block so master can read it with single FC04
+     * 32 bit value is stored as 2 register, high word first
+     */
+    enum ExtendedRegister : uint8_t {
+        EXT_SYSTEM_VOLTAGE = 0,
+        EXT_LOAD_VOLTAGE_1,
+        EXT_LOAD_VOLTAGE_2,
+        EXT_LOAD_VOLTAGE_3,
+        EXT_LOAD_CURRENT_1,
+        EXT_LOAD_CURRENT_2,
+        EXT_LOAD_CURRENT_3,
+        EXT_FLAG_1,
+        EXT_FLAG_2,
+        EXT_FLAG_3,
+        EXT_FEEDBACK_STATUS,
+        EXT_SYSTEM_STATUS,
+        EXT_COIL_STATUS,
+        EXT_BOOT_TIME,
+        EXT_UPTIME = 14, //2 register, uptime in seconds
+        EXT_RELAY_ON_FAIL_1 = 16, //2 register, each channel has on fail and off fail counter
+        EXT_RELAY_OFF_FAIL_1 = 18,
+        EXT_RELAY_ON_FAIL_2 = 20,
+        EXT_RELAY_OFF_FAIL_2 = 22,
+        EXT_RELAY_ON_FAIL_3 = 24,
+        EXT_RELAY_OFF_FAIL_3 = 26,
+        EXT_LOAD_POWER_1 = 28, //load power in 0.1 W, from time aligned voltage and current
+        EXT_LOAD_POWER_2,
+        EXT_LOAD_POWER_3,
+        EXT_SIZE = 31
+    };
+
+    typedef std::array<uint16_t, EXT_SIZE> extendedRegisterArray; //extended telemetry register
+
+    /**
+     * Telemetry register, built by the control loop and published as one snapshot
+     */
+    struct telemetryRegister
     {
-        std::array<uint16_t, 12> inputRegister; //reserve 12 input register
-        std::array<uint16_t, 35> holdingRegister; //reserve 35 holding register
+        inputRegisterArray inputRegister; //reserve 12 input register
+        extendedRegisterArray extendedRegister; //extended telemetry block
 
-        modbusRegister()
+        telemetryRegister()
         {
             inputRegister.fill(0); //fill input register with zero value
-            holdingRegister.fill(0); //fill holding register with zero value
+            extendedRegister.fill(0); //fill extended register with zero value
         }
 
         /**
@@ -75,6 +131,7 @@ namespace LoadModbus {
         void assignLoadVoltage1(int16_t value)
         {
             inputRegister[0] = value;
+            extendedRegister[EXT_LOAD_VOLTAGE_1] = value;
         }
 
         /**
@@ -84,6 +141,7 @@ namespace LoadModbus {
         void assignLoadVoltage2(int16_t value)
         {
             inputRegister[1] = value;
+            extendedRegister[EXT_LOAD_VOLTAGE_2] = value;
         }
 
         /**
@@ -93,6 +151,7 @@ namespace LoadModbus {
         void assignLoadVoltage3(int16_t value)
         {
             inputRegister[2] = value;
+            extendedRegister[EXT_LOAD_VOLTAGE_3] = value;
         }
 
         /**
@@ -102,6 +161,7 @@ namespace LoadModbus {
         void assignSystemVoltage(int16_t value)
         {
             inputRegister[3] = value;
+            extendedRegister[EXT_SYSTEM_VOLTAGE] = value;
         }
 
         /**
@@ -111,6 +171,7 @@ namespace LoadModbus {
         void assignLoadCurrent1(int16_t value)
         {
             inputRegister[4] = value;
+            extendedRegister[EXT_LOAD_CURRENT_1] = value;
         }
 
         /**
@@ -120,6 +181,7 @@ namespace LoadModbus {
         void assignLoadCurrent2(int16_t value)
         {
             inputRegister[5] = value;
+            extendedRegister[EXT_LOAD_CURRENT_2] = value;
         }
 
         /**
@@ -129,6 +191,7 @@ namespace LoadModbus {
         void assignLoadCurrent3(int16_t value)
         {
             inputRegister[6] = value;
+            extendedRegister[EXT_LOAD_CURRENT_3] = value;
         }
 
         /**
@@ -138,6 +201,7 @@ namespace LoadModbus {
         void assignFlag1(uint16_t value)
         {
             inputRegister[7] = value;
+            extendedRegister[EXT_FLAG_1] = value;
         }
 
         /**
@@ -147,6 +211,7 @@ namespace LoadModbus {
         void assignFlag2(uint16_t value)
         {
             inputRegister[8] = value;
+            extendedRegister[EXT_FLAG_2] = value;
         }
 
         /**
@@ -156,6 +221,7 @@ namespace LoadModbus {
         void assignFlag3(uint16_t value)
         {
             inputRegister[9] = value;
+            extendedRegister[EXT_FLAG_3] = value;
         }
 
         /**
@@ -165,6 +231,7 @@ namespace LoadModbus {
         void assignFeedbackStatus(uint16_t value)
         {
             inputRegister[10] = value;
+            extendedRegister[EXT_FEEDBACK_STATUS] = value;
         }
 
         /**
@@ -174,6 +241,85 @@ namespace LoadModbus {
         void assignSystemStatus(uint16_t value)
         {
             inputRegister[11] = value;
+            extendedRegister[EXT_SYSTEM_STATUS] = value;
+        }
+
+        /**
+         * assign boot time register, only in the extended block so the shared input register stay the same in every target
+         * @param[in]   value   time from boot until ready in ms
+         */
+        void assignBootTime(uint16_t value)
+        {
+            extendedRegister[EXT_BOOT_TIME] = value;
+        }
+
+        /**
+         * assign coil status register
+         * @param[in]   value   coil state packed as bit, bit 0 is coil 0
+         */
+        void assignCoilStatus(uint16_t value)
+        {
+            extendedRegister[EXT_COIL_STATUS] = value;
+        }
+
+        /**
+         * assign uptime register
+         * @param[in]   value   uptime in seconds
+         */
+        void assignUptime(uint32_t value)
+        {
+            assignExtended32(EXT_UPTIME, value);
+        }
+
+        /**
+         * assign relay fail counter register
+         * @param[in]   channel channel index (0 - 2)
+         * @param[in]   onFail  number of failed relay on since boot
+         * @param[in]   offFail number of failed relay off since boot
+         */
+        void assignRelayFailCount(size_t channel, uint32_t onFail, uint32_t offFail)
+        {
+            if (channel > 2)
+            {
+                return;
+            }
+            assignExtended32(EXT_RELAY_ON_FAIL_1 + channel * 4, onFail);
+            assignExtended32(EXT_RELAY_OFF_FAIL_1 + channel * 4, offFail);
+        }
+
+        /**
+         * assign load power register
+         * @param[in]   channel channel index (0 - 2)
+         * @param[in]   value   load power in 0.1 W
+         */
+        void assignLoadPower(size_t channel, int16_t value)
+        {
+            if (channel > 2)
+            {
+                return;
+            }
+            extendedRegister[EXT_LOAD_POWER_1 + channel] = value;
+        }
+
+        /**
+         * assign 32 bit value into 2 extended register, high word first
+         * @param[in]   index   index of high word
+         * @param[in]   value   value to be assigned into
+         */
+        void assignExtended32(size_t index, uint32_t value)
+        {
+            extendedRegister[index] = value >> 16;
+            extendedRegister[index + 1] = value & 0xFFFF;
+        }
+    };
+
+    struct modbusRegister : telemetryRegister
+    {
+        std::array<uint16_t, 35> holdingRegister; //reserve 35 holding register
+
+        modbusRegister()
+        {
+            holdingRegister.fill(0); //fill holding register with zero value
         }
 
         /**
@@ -193,6 +339,66 @@ namespace LoadModbus {
             return regsNumber;
         }
     };
+
+    /**
+     * Read only view into existing register array, no data is copied
+     */
+    struct registerView
+    {
+        const uint16_t *data = NULL; //pointer to live register
+        size_t size = 0; //number of register
+
+        /**
+         * check if the range is inside the view
+         * @param[in]   index   start index
+         * @param[in]   count   number of register
+         * 
+         * @return  true if the range is valid
+         */
+        bool contains(size_t index, size_t count) const
+        {
+            return data != NULL && count > 0 && index + count <= size;
+        }
+
+        uint16_t operator[](size_t index) const
+        {
+            return data[index];
+        }
+    };
+
+    /**
+     * Unified register bank
+     * 
+     * holding register is view into LoadParameter shadow register
+     * input register is view into live telemetry register
+     */
+    struct registerBank
+    {
+        registerView holdingRegister;
+        registerView inputRegister;
+
+        /**
+         * attach holding register view
+         * @param[in]   regs    pointer to register array
+         * @param[in]   size    number of register
+         */
+        void attachHoldingRegister(const uint16_t *regs, size_t size)
+        {
+            holdingRegister.data = regs;
+            holdingRegister.size = size;
+        }
+
+        /**
+         * attach input register view
+         * @param[in]   regs    pointer to register array
+         * @param[in]   size    number of register
+         */
+        void attachInputRegister(const uint16_t *regs, size_t size)
+        {
+            inputRegister.data = regs;
+            inputRegister.size = size;
+        }
+    };
 }
 
 /**
@@ -215,6 +421,7 @@ struct LoadParamsSetting {
     uint16_t loadShortCircuitDisconnect = 2000;    // short circuit current in 0.01A
     uint16_t loadShortCircuitDetectionTime = 20;    // wait time in miliseconds (ms)
     uint16_t loadShortCircuitReconnectTime = 4000;    // reconnect time in miliseconds (ms)
+    uint16_t loadOverpowerDisconnect = 0;    // overpower in 0.1W, 0 to disable, use overcurrent detection and reconnect time
     bool activeLow = false; //set to true if sink (low side switch), set false if source (high side switch)
 };
 
@@ -226,7 +433,10 @@ struct LoadParamsSetting {
  * bit 0 = overvoltage bit
  * bit 1 = undervoltage bit
  * bit 2 = overcurrent bit
- * bit 3 - 15 = reserved for future use
+ * bit 3 = short circuit bit
+ * bit 4 = sensor fault bit, measurement is stale and the load is disconnected
+ * bit 5 = overpower bit
+ * bit 6 - 15 = reserved for future use
  */
 union bitField {
     struct flagStatus
@@ -235,7 +445,9 @@ union bitField {
         uint16_t overvoltage : 1;
         uint16_t overcurrent : 1;
         uint16_t shortCircuit : 1;
-        uint16_t : 12;
+        uint16_t sensorFault : 1;
+        uint16_t overpower : 1;
+        uint16_t : 10;
     } flag;
     uint16_t value;
 };
@@ -254,11 +466,14 @@ class LoadHandle {
         uint16_t _loadShortCircuitDisconnect;
         uint16_t _loadShortCircuitDetectionTime;
         uint16_t _loadShortCircuitReconnectTime;
+        uint16_t _loadOverpowerDisconnect = 0;
         bitField _bitStatus;
         unsigned long _lastOcCheck;
         unsigned long _lastOcReconnect;
         unsigned long _lastScCheck;
         unsigned long _lastScReconnect;
+        unsigned long _lastOpCheck;
+        unsigned long _lastOpReconnect;
         bool _isActiveLow;
         bool _state;
 
@@ -266,12 +481,15 @@ class LoadHandle {
         LoadHandle();
         void setParams(const LoadParamsSetting &load_params_t); //set object parameter
         void printParams(); //print parameter stored
-        void loop(int16_t loadVoltage, int16_t loadCurrent); //main loop
+        void loop(int16_t loadVoltage, int16_t loadCurrent, int16_t loadPower = 0); //main loop, power is used only when overpower is enabled
         bool getAction(); //get action
         bool isOvervoltage(); //get overvoltage flag
         bool isUndervoltage(); //get undervoltage flag
         bool isOvercurrent(); //get overcurrent flag
         bool isShortCircuit(); //get short circuit flag
+        bool isOverpower(); //get overpower flag
+        void setSensorFault(bool isFault); //set when measurement is stale, the load is disconnected until it is cleared
+        bool isSensorFault(); //get sensor fault flag
         uint16_t getStatus(); //get all flag status as uint16
         ~LoadHandle();
 };
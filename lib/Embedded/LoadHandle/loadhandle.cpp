@@ -6,6 +6,8 @@ LoadHandle::LoadHandle()
     _lastOcReconnect = millis();
     _lastScCheck = millis();
     _lastScReconnect = millis();
+    _lastOpCheck = millis();
+    _lastOpReconnect = millis();
 }
 
 /**
@@ -25,6 +27,7 @@ void LoadHandle::setParams(const LoadParamsSetting &load_params_t)
     _loadShortCircuitDisconnect = load_params_t.loadShortCircuitDisconnect;
     _loadShortCircuitDetectionTime = load_params_t.loadShortCircuitDetectionTime;
     _loadShortCircuitReconnectTime = load_params_t.loadShortCircuitReconnectTime;
+    _loadOverpowerDisconnect = load_params_t.loadOverpowerDisconnect;
     _isActiveLow = load_params_t.activeLow;
 }
 
@@ -43,6 +46,7 @@ void LoadHandle::printParams()
     ESP_LOGI(_TAG, "short circuit disconnect : %d\n", _loadShortCircuitDisconnect);
     ESP_LOGI(_TAG, "short circuit detection time : %d\n", _loadShortCircuitDetectionTime);
     ESP_LOGI(_TAG, "short circuit reconnect time : %d\n", _loadShortCircuitReconnectTime);
+    ESP_LOGI(_TAG, "overpower disconnect : %d\n", _loadOverpowerDisconnect);
     ESP_LOGI(_TAG, "output mode : %d\n", _isActiveLow);
 }
 
@@ -52,10 +56,18 @@ void LoadHandle::printParams()
  * 
  * @param[in]   loadVoltage load voltage in 0.1V
  * @param[in]   loadCurrent load current in 0.01A
+ * @param[in]   loadPower   load power in 0.1W, computed from voltage and current sampled at the same time
  */
-void LoadHandle::loop(int16_t loadVoltage, int16_t loadCurrent)
+void LoadHandle::loop(int16_t loadVoltage, int16_t loadCurrent, int16_t loadPower)
 {
+    if (_bitStatus.flag.sensorFault) //stale measurement, keep the load disconnected and hold every protection flag
+    {
+        _state = _isActiveLow;
+        return;
+    }
+
     loadCurrent = abs(loadCurrent); //make current value as absolute (always positive)
+    loadPower = abs(loadPower);
 
     // ESP_LOGI(_TAG, "current : %d\n", loadCurrent);
     // ESP_LOGI(_TAG, "voltage : %d\n", loadVoltage);
@@ -144,7 +156,36 @@ void LoadHandle::loop(int16_t loadVoltage, int16_t loadCurrent)
         _lastOcReconnect = millis();
     }
 
-    if (!_bitStatus.flag.overvoltage && !_bitStatus.flag.undervoltage && !_bitStatus.flag.overcurrent && !_bitStatus.flag.shortCircuit) //check if no flag is enabled
+    /**
+     * Overpower detection, disabled when disconnect parameter is 0
+     */
+    if (_loadOverpowerDisconnect && loadPower > _loadOverpowerDisconnect && !_bitStatus.flag.overpower && !_bitStatus.flag.shortCircuit) //check if power is above overpower parameter and flag is not yet set(first time occured)
+    {
+        if (millis() - _lastOpCheck > _loadOcDetectionTime) //same detection time as overcurrent
+        {
+            _bitStatus.flag.overpower = 1; //set overpower flag
+            _lastOpCheck = millis(); //update time of last overpower check
+        }
+    }
+    else
+    {
+        _lastOpCheck = millis();
+    }
+
+    if (_bitStatus.flag.overpower) //check if the flag is overpower
+    {
+        if (millis() - _lastOpReconnect > _loadOcReconnectTime || !_loadOverpowerDisconnect) //same reconnect time as overcurrent, reset immediately when disabled
+        {
+            _bitStatus.flag.overpower = 0; //reset overpower flag
+            _lastOpReconnect = millis(); //update time of last overpower reconnect time
+        }
+    }
+    else
+    {
+        _lastOpReconnect = millis();
+    }
+
+    if (!_bitStatus.flag.overvoltage && !_bitStatus.flag.undervoltage && !_bitStatus.flag.overcurrent && !_bitStatus.flag.shortCircuit && !_bitStatus.flag.overpower) //check if no flag is enabled
     {
         _state = !_isActiveLow; //return active, if activelow is enabled, this will return false otherwise return true
     }
@@ -204,6 +245,36 @@ bool LoadHandle::isShortCircuit()
     return _bitStatus.flag.shortCircuit;
 }
 
+/**
+ * Get overpower status
+ * 
+ * @return overpower flag bit
+ */
+bool LoadHandle::isOverpower()
+{
+    return _bitStatus.flag.overpower;
+}
+
+/**
+ * Set sensor fault, the load is disconnected while the flag is set
+ * 
+ * @param[in]   isFault true if voltage or current measurement is stale
+ */
+void LoadHandle::setSensorFault(bool isFault)
+{
+    _bitStatus.flag.sensorFault = isFault;
+}
+
+/**
+ * Get sensor fault status
+ * 
+ * @return  sensor fault flag bit
+ */
+bool LoadHandle::isSensorFault()
+{
+    return _bitStatus.flag.sensorFault;
+}
+
 /**
  * Get status flag in uint16
  * 
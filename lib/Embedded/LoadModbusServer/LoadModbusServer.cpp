@@ -0,0 +1,1027 @@
+#include "LoadModbusServer.h"
+
+const std::array<uint8_t, LMS_MAX_FUNCTION> LoadModbusServer::_functionCode = {
+    READ_COIL, WRITE_COIL, WRITE_MULT_COILS, READ_HOLD_REGISTER, READ_INPUT_REGISTER,
+    WRITE_HOLD_REGISTER, WRITE_MULT_REGISTERS, R_W_MULT_REGISTERS, ENCAPSULATED_INTERFACE
+};
+
+LoadModbusServer::LoadModbusServer()
+{
+    _mutex = xSemaphoreCreateRecursiveMutex();
+}
+
+/**
+ * Insert block into table, keep table sorted by address
+ *
+ * @param[in]   table   register table
+ * @param[in]   address start address
+ * @param[in]   size    number of register
+ * @param[in]   read    read handler
+ * @param[in]   write   write handler
+ *
+ * @return  true if success, false if table is full or address is overlapped
+ */
+bool LoadModbusServer::addBlock(LoadModbus::register_table_t &table, uint16_t address, uint16_t size, LoadModbus::ReadHandler read, LoadModbus::WriteHandler write)
+{
+    if (table.size >= table.block.size() || size == 0 || (uint32_t)address + size > 0x10000)
+    {
+        return false;
+    }
+
+    size_t pos = 0;
+    while (pos < table.size && table.block[pos].address < address) //find insert position
+    {
+        pos++;
+    }
+
+    if (pos > 0 && (uint32_t)table.block[pos - 1].address + table.block[pos - 1].size > address) //overlap with previous block
+    {
+        return false;
+    }
+
+    if (pos < table.size && (uint32_t)address + size > table.block[pos].address) //overlap with next block
+    {
+        return false;
+    }
+
+    for (size_t i = table.size; i > pos; i--)
+    {
+        table.block[i] = table.block[i - 1];
+    }
+    table.block[pos].address = address;
+    table.block[pos].size = size;
+    table.block[pos].read = read;
+    table.block[pos].write = write;
+    table.size++;
+    return true;
+}
+
+/**
+ * Add holding register block
+ *
+ * @param[in]   address start address
+ * @param[in]   size    number of register
+ * @param[in]   read    read handler
+ * @param[in]   write   write handler, empty for read only block
+ *
+ * @return  true if success
+ */
+bool LoadModbusServer::addHoldingRegister(uint16_t address, uint16_t size, LoadModbus::ReadHandler read, LoadModbus::WriteHandler write)
+{
+    return addBlock(_holdingTable, address, size, read, write);
+}
+
+/**
+ * Add input register block
+ *
+ * @param[in]   address start address
+ * @param[in]   size    number of register
+ * @param[in]   read    read handler
+ *
+ * @return  true if success
+ */
+bool LoadModbusServer::addInputRegister(uint16_t address, uint16_t size, LoadModbus::ReadHandler read)
+{
+    return addBlock(_inputTable, address, size, read, nullptr);
+}
+
+/**
+ * Set coil storage
+ *
+ * @param[in]   address start address of coil
+ * @param[in]   coils   pointer to coil storage
+ */
+void LoadModbusServer::setCoil(uint16_t address, CoilData *coils)
+{
+    _coilAddress = address;
+    _coils = coils;
+}
+
+/**
+ * Set coil write handler
+ *
+ * @brief   handler is called for every written coil before it is stored, coil consumed by the handler
+ *          is not stored so event driven coil does not need to be cleared by the loop
+ *
+ * @param[in]   handler coil handler
+ */
+void LoadModbusServer::setCoilHandler(LoadModbus::CoilHandler handler)
+{
+    _coilHandler = handler;
+}
+
+/**
+ * Pass coil into handler, store it if it is not consumed
+ *
+ * @param[in]   index   coil index from coil start address
+ * @param[in]   value   coil value
+ *
+ * @return  true if success
+ */
+bool LoadModbusServer::writeCoilValue(uint16_t index, bool value)
+{
+    if (_coilHandler && _coilHandler(index, value))
+    {
+        return true;
+    }
+    return _coils->set(index, value);
+}
+
+/**
+ * Set device identification object, object is kept sorted by id
+ *
+ * @param[in]   id  object id, refer to DeviceObject
+ * @param[in]   value   object value, must stay valid for the lifetime of the server
+ *
+ * @return  true if success, false if object list is full or value is too long
+ */
+bool LoadModbusServer::setDeviceObject(uint8_t id, const char* value)
+{
+    if (value == NULL || strlen(value) > LMS_MAX_FRAME - 10)
+    {
+        return false;
+    }
+
+    size_t pos = 0;
+    while (pos < _deviceObjectSize && _deviceObject[pos].id < id)
+    {
+        pos++;
+    }
+
+    if (pos < _deviceObjectSize && _deviceObject[pos].id == id) //replace existing object
+    {
+        _deviceObject[pos].value = value;
+        return true;
+    }
+
+    if (_deviceObjectSize >= _deviceObject.size())
+    {
+        return false;
+    }
+
+    for (size_t i = _deviceObjectSize; i > pos; i--)
+    {
+        _deviceObject[i] = _deviceObject[i - 1];
+    }
+    _deviceObject[pos].id = id;
+    _deviceObject[pos].value = value;
+    _deviceObjectSize++;
+    return true;
+}
+
+/**
+ * Read range of register, the range may cross several contiguous block
+ *
+ * @param[in]   table   register table
+ * @param[in]   address start address
+ * @param[in]   count   number of register
+ * @param[out]  buff    buffer to store register value
+ *
+ * @return  SUCCESS, ILLEGAL_DATA_ADDRESS or SERVER_DEVICE_FAILURE
+ */
+Error LoadModbusServer::readTable(const LoadModbus::register_table_t &table, uint16_t address, uint16_t count, uint16_t *buff)
+{
+    uint32_t current = address;
+    uint32_t end = (uint32_t)address + count;
+    Error err = SUCCESS;
+    xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+    for (size_t i = 0; i < table.size && current < end; i++)
+    {
+        const LoadModbus::register_block_t &block = table.block[i];
+        uint32_t blockEnd = (uint32_t)block.address + block.size;
+        if (blockEnd <= current)
+        {
+            continue;
+        }
+        if (block.address > current) //gap between block
+        {
+            break;
+        }
+        uint16_t chunk = (end < blockEnd ? end : blockEnd) - current;
+        if (!block.read || !block.read(current - block.address, chunk, buff + (current - address)))
+        {
+            err = SERVER_DEVICE_FAILURE;
+            break;
+        }
+        current += chunk;
+    }
+    xSemaphoreGiveRecursive(_mutex);
+    if (err != SUCCESS)
+    {
+        return err;
+    }
+    return current == end ? SUCCESS : ILLEGAL_DATA_ADDRESS;
+}
+
+/**
+ * Write range of register, the range may cross several contiguous block
+ *
+ * @param[in]   table   register table
+ * @param[in]   address start address
+ * @param[in]   count   number of register
+ * @param[in]   buff    value to be written
+ *
+ * @return  SUCCESS, ILLEGAL_DATA_ADDRESS or ILLEGAL_DATA_VALUE
+ */
+Error LoadModbusServer::writeTable(const LoadModbus::register_table_t &table, uint16_t address, uint16_t count, uint16_t *buff)
+{
+    uint32_t end = (uint32_t)address + count;
+    uint32_t current = address;
+    for (size_t i = 0; i < table.size && current < end; i++) //validate whole range before writing anything
+    {
+        const LoadModbus::register_block_t &block = table.block[i];
+        uint32_t blockEnd = (uint32_t)block.address + block.size;
+        if (blockEnd <= current)
+        {
+            continue;
+        }
+        if (block.address > current || !block.write)
+        {
+            return ILLEGAL_DATA_ADDRESS;
+        }
+        current = end < blockEnd ? end : blockEnd;
+    }
+    if (current != end)
+    {
+        return ILLEGAL_DATA_ADDRESS;
+    }
+
+    Error err = SUCCESS;
+    current = address;
+    xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+    for (size_t i = 0; i < table.size && current < end; i++)
+    {
+        const LoadModbus::register_block_t &block = table.block[i];
+        uint32_t blockEnd = (uint32_t)block.address + block.size;
+        if (blockEnd <= current)
+        {
+            continue;
+        }
+        uint16_t chunk = (end < blockEnd ? end : blockEnd) - current;
+        if (!block.write(current - block.address, chunk, buff + (current - address)))
+        {
+            err = ILLEGAL_DATA_VALUE;
+            break;
+        }
+        current += chunk;
+    }
+    xSemaphoreGiveRecursive(_mutex);
+    return err;
+}
+
+/**
+ * Build response in single allocation, the message buffer is reserved for the whole frame before it is appended
+ *
+ * @param[in]   frame   response frame
+ * @param[in]   len length of frame
+ *
+ * @return  response message
+ */
+ModbusMessage LoadModbusServer::buildResponse(const uint8_t *frame, uint16_t len)
+{
+    ModbusMessage response(len);
+    response.add(frame, len);
+    return response;
+}
+
+/**
+ * Build read register response in single append
+ *
+ * @param[in]   request request message
+ * @param[in]   count   number of register
+ * @param[in]   buff    register value
+ *
+ * @return  response message
+ */
+ModbusMessage LoadModbusServer::buildRegisterResponse(const ModbusMessage &request, uint16_t count, const uint16_t *buff)
+{
+    uint8_t frame[LMS_MAX_FRAME];
+    size_t len = 0;
+    frame[len++] = request.getServerID();
+    frame[len++] = request.getFunctionCode();
+    frame[len++] = count * 2;
+    for (size_t i = 0; i < count; i++)
+    {
+        frame[len++] = buff[i] >> 8;
+        frame[len++] = buff[i] & 0xFF;
+    }
+    return buildResponse(frame, len);
+}
+
+/**
+ * FC01 read coil
+ *
+ * @param[in]   request request message
+ *
+ * @return  response message
+ */
+ModbusMessage LoadModbusServer::readCoil(const ModbusMessage &request)
+{
+    ModbusMessage response;
+    uint16_t start = 0;
+    uint16_t numCoils = 0;
+    request.get(2, start, numCoils);
+
+    if (_coils == NULL || start < _coilAddress || numCoils == 0 || numCoils > LMS_MAX_COIL || (start - _coilAddress) + numCoils > _coils->coils())
+    {
+        response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_ADDRESS);
+        return response;
+    }
+
+    uint8_t frame[3 + LMS_MAX_COIL / 8];
+    uint8_t numBytes = ((numCoils - 1) >> 3) + 1;
+    frame[0] = request.getServerID();
+    frame[1] = request.getFunctionCode();
+    frame[2] = numBytes;
+    memset(frame + 3, 0, numBytes);
+    xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+    for (size_t i = 0; i < numCoils; i++) //pack coil into bit
+    {
+        if ((*_coils)[start - _coilAddress + i])
+        {
+            frame[3 + (i >> 3)] |= 1 << (i & 0x07);
+        }
+    }
+    xSemaphoreGiveRecursive(_mutex);
+    return buildResponse(frame, 3 + numBytes);
+}
+
+/**
+ * FC05 write single coil
+ *
+ * @param[in]   request request message
+ *
+ * @return  response message
+ */
+ModbusMessage LoadModbusServer::writeCoil(const ModbusMessage &request)
+{
+    ModbusMessage response;
+    uint16_t start = 0;
+    uint16_t state = 0;
+    request.get(2, start, state);
+
+    if (_coils == NULL || start < _coilAddress || (start - _coilAddress) >= _coils->coils())
+    {
+        response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_ADDRESS);
+        return response;
+    }
+
+    if (state != 0x0000 && state != 0xFF00)
+    {
+        response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_VALUE);
+        return response;
+    }
+
+    xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+    bool isSet = writeCoilValue(start - _coilAddress, state == 0xFF00);
+    xSemaphoreGiveRecursive(_mutex);
+    if (!isSet)
+    {
+        response.setError(request.getServerID(), request.getFunctionCode(), SERVER_DEVICE_FAILURE);
+        return response;
+    }
+    return ECHO_RESPONSE;
+}
+
+/**
+ * FC0F write multiple coil
+ *
+ * @param[in]   request request message
+ *
+ * @return  response message
+ */
+ModbusMessage LoadModbusServer::writeMultipleCoil(const ModbusMessage &request)
+{
+    ModbusMessage response;
+    uint16_t start = 0;
+    uint16_t numCoils = 0;
+    uint8_t numBytes = 0;
+    uint16_t index = request.get(2, start, numCoils, numBytes);
+
+    if (_coils == NULL || start < _coilAddress || numCoils == 0 || numCoils > LMS_MAX_COIL || (start - _coilAddress) + numCoils > _coils->coils())
+    {
+        response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_ADDRESS);
+        return response;
+    }
+
+    if (numBytes != ((numCoils - 1) >> 3) + 1 || request.size() < index + numBytes)
+    {
+        response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_VALUE);
+        return response;
+    }
+
+    uint8_t coilset[LMS_MAX_COIL / 8];
+    for (size_t i = 0; i < numBytes; i++)
+    {
+        index = request.get(index, coilset[i]);
+    }
+    bool isSet = true;
+    xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+    for (size_t i = 0; i < numCoils && isSet; i++)
+    {
+        isSet = writeCoilValue(start - _coilAddress + i, (coilset[i >> 3] >> (i & 0x07)) & 0x01);
+    }
+    xSemaphoreGiveRecursive(_mutex);
+    if (!isSet)
+    {
+        response.setError(request.getServerID(), request.getFunctionCode(), SERVER_DEVICE_FAILURE);
+        return response;
+    }
+    return buildResponse(request.data(), 6); //echo server id, function code, start and quantity
+}
+
+/**
+ * FC03 read holding register
+ *
+ * @param[in]   request request message
+ *
+ * @return  response message
+ */
+ModbusMessage LoadModbusServer::readHoldingRegister(const ModbusMessage &request)
+{
+    ModbusMessage response;
+    uint16_t address = 0;
+    uint16_t words = 0;
+    request.get(2, address, words);
+
+    if (words == 0 || words > LMS_MAX_READ_REGISTER)
+    {
+        response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_VALUE);
+        return response;
+    }
+
+    uint16_t buff[LMS_MAX_READ_REGISTER];
+    Error err = readTable(_holdingTable, address, words, buff);
+    if (err != SUCCESS)
+    {
+        response.setError(request.getServerID(), request.getFunctionCode(), err);
+        return response;
+    }
+    return buildRegisterResponse(request, words, buff);
+}
+
+/**
+ * FC04 read input register
+ *
+ * @param[in]   request request message
+ *
+ * @return  response message
+ */
+ModbusMessage LoadModbusServer::readInputRegister(const ModbusMessage &request)
+{
+    ModbusMessage response;
+    uint16_t address = 0;
+    uint16_t words = 0;
+    request.get(2, address, words);
+
+    if (words == 0 || words > LMS_MAX_READ_REGISTER)
+    {
+        response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_VALUE);
+        return response;
+    }
+
+    uint16_t buff[LMS_MAX_READ_REGISTER];
+    Error err = readTable(_inputTable, address, words, buff);
+    if (err != SUCCESS)
+    {
+        response.setError(request.getServerID(), request.getFunctionCode(), err);
+        return response;
+    }
+    return buildRegisterResponse(request, words, buff);
+}
+
+/**
+ * FC06 write single holding register
+ *
+ * @param[in]   request request message
+ *
+ * @return  response message
+ */
+ModbusMessage LoadModbusServer::writeHoldingRegister(const ModbusMessage &request)
+{
+    ModbusMessage response;
+    uint16_t address = 0;
+    uint16_t data = 0;
+    request.get(2, address, data);
+
+    Error err = writeTable(_holdingTable, address, 1, &data);
+    if (err != SUCCESS)
+    {
+        response.setError(request.getServerID(), request.getFunctionCode(), err);
+        return response;
+    }
+    return ECHO_RESPONSE;
+}
+
+/**
+ * FC10 write multiple holding register
+ *
+ * @param[in]   request request message
+ *
+ * @return  response message
+ */
+ModbusMessage LoadModbusServer::writeMultipleHoldingRegister(const ModbusMessage &request)
+{
+    ModbusMessage response;
+    uint16_t address = 0;
+    uint16_t words = 0;
+    uint8_t bytes = 0;
+    uint16_t index = request.get(2, address, words, bytes);
+
+    if (words == 0 || words > LMS_MAX_WRITE_REGISTER || bytes != words * 2 || request.size() < index + bytes)
+    {
+        response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_VALUE);
+        return response;
+    }
+
+    uint16_t buff[LMS_MAX_WRITE_REGISTER];
+    for (size_t i = 0; i < words; i++)
+    {
+        index = request.get(index, buff[i]);
+    }
+
+    Error err = writeTable(_holdingTable, address, words, buff);
+    if (err != SUCCESS)
+    {
+        response.setError(request.getServerID(), request.getFunctionCode(), err);
+        return response;
+    }
+    return buildResponse(request.data(), 6); //echo server id, function code, address and quantity
+}
+
+/**
+ * FC17 read/write multiple register, write is executed before read
+ *
+ * @param[in]   request request message
+ *
+ * @return  response message
+ */
+ModbusMessage LoadModbusServer::readWriteMultipleRegister(const ModbusMessage &request)
+{
+    ModbusMessage response;
+    uint16_t readAddress = 0;
+    uint16_t readWords = 0;
+    uint16_t writeAddress = 0;
+    uint16_t writeWords = 0;
+    uint8_t bytes = 0;
+    uint16_t index = request.get(2, readAddress, readWords, writeAddress, writeWords);
+    index = request.get(index, bytes);
+
+    if (readWords == 0 || readWords > LMS_MAX_READ_REGISTER || writeWords == 0 || writeWords > LMS_MAX_RW_WRITE_REGISTER
+        || bytes != writeWords * 2 || request.size() < index + bytes)
+    {
+        response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_VALUE);
+        return response;
+    }
+
+    uint16_t writeBuff[LMS_MAX_RW_WRITE_REGISTER];
+    for (size_t i = 0; i < writeWords; i++)
+    {
+        index = request.get(index, writeBuff[i]);
+    }
+
+    uint16_t readBuff[LMS_MAX_READ_REGISTER];
+    xSemaphoreTakeRecursive(_mutex, portMAX_DELAY); //no other request between write and read
+    Error err = writeTable(_holdingTable, writeAddress, writeWords, writeBuff);
+    if (err == SUCCESS)
+    {
+        err = readTable(_holdingTable, readAddress, readWords, readBuff);
+    }
+    xSemaphoreGiveRecursive(_mutex);
+
+    if (err != SUCCESS)
+    {
+        response.setError(request.getServerID(), request.getFunctionCode(), err);
+        return response;
+    }
+    return buildRegisterResponse(request, readWords, readBuff);
+}
+
+/**
+ * FC2B MEI 0E read device identification
+ *
+ * @brief   support basic and regular stream access (code 01, 02), extended stream (code 03) and individual access (code 04).
+ *          object that does not fit in a single frame is continued with more follows flag
+ *
+ * @param[in]   request request message
+ *
+ * @return  response message
+ */
+ModbusMessage LoadModbusServer::readDeviceIdentification(const ModbusMessage &request)
+{
+    ModbusMessage response;
+    uint8_t meiType = 0;
+    uint8_t code = 0;
+    uint8_t objectId = 0;
+    request.get(2, meiType, code, objectId);
+
+    if (meiType != 0x0E || code < 0x01 || code > 0x04)
+    {
+        response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_VALUE);
+        return response;
+    }
+
+    uint8_t firstId = 0;
+    uint8_t lastId = 0;
+    switch (code)
+    {
+    case 0x01:
+        lastId = LoadModbus::MAJOR_MINOR_REVISION;
+        break;
+    case 0x02:
+        lastId = LoadModbus::USER_APPLICATION_NAME;
+        break;
+    case 0x03:
+        lastId = 0xFF;
+        break;
+    default:
+        firstId = objectId;
+        lastId = objectId;
+        break;
+    }
+
+    size_t pos = 0;
+    while (pos < _deviceObjectSize && _deviceObject[pos].id < objectId)
+    {
+        pos++;
+    }
+
+    if (code == 0x04 && (pos >= _deviceObjectSize || _deviceObject[pos].id != objectId))
+    {
+        response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_ADDRESS);
+        return response;
+    }
+
+    if (objectId < firstId || objectId > lastId || pos >= _deviceObjectSize || _deviceObject[pos].id != objectId) //unknown object, restart stream from first object
+    {
+        pos = 0;
+        while (pos < _deviceObjectSize && _deviceObject[pos].id < firstId)
+        {
+            pos++;
+        }
+    }
+
+    uint8_t frame[LMS_MAX_FRAME];
+    size_t len = 0;
+    frame[len++] = request.getServerID();
+    frame[len++] = request.getFunctionCode();
+    frame[len++] = 0x0E;
+    frame[len++] = code;
+    frame[len++] = 0x83; //conformity level : extended identification, stream and individual access
+    size_t moreFollows = len++;
+    size_t nextObject = len++;
+    size_t numObject = len++;
+    frame[moreFollows] = 0x00;
+    frame[nextObject] = 0x00;
+    frame[numObject] = 0;
+
+    for (; pos < _deviceObjectSize && _deviceObject[pos].id <= lastId; pos++)
+    {
+        size_t valueLen = strlen(_deviceObject[pos].value);
+        if (len + 2 + valueLen > sizeof(frame))
+        {
+            frame[moreFollows] = 0xFF;
+            frame[nextObject] = _deviceObject[pos].id;
+            break;
+        }
+        frame[len++] = _deviceObject[pos].id;
+        frame[len++] = valueLen;
+        memcpy(frame + len, _deviceObject[pos].value, valueLen);
+        len += valueLen;
+        frame[numObject]++;
+    }
+    return buildResponse(frame, len);
+}
+
+/**
+ * Dispatch request into function code handler and record its statistic
+ *
+ * @param[in]   request request message
+ *
+ * @return  response message
+ */
+ModbusMessage LoadModbusServer::serve(const ModbusMessage &request)
+{
+    unsigned long start = micros();
+    ModbusMessage response;
+    switch (request.getFunctionCode())
+    {
+    case READ_COIL:
+        response = readCoil(request);
+        break;
+    case WRITE_COIL:
+        response = writeCoil(request);
+        break;
+    case WRITE_MULT_COILS:
+        response = writeMultipleCoil(request);
+        break;
+    case READ_HOLD_REGISTER:
+        response = readHoldingRegister(request);
+        break;
+    case READ_INPUT_REGISTER:
+        response = readInputRegister(request);
+        break;
+    case WRITE_HOLD_REGISTER:
+        response = writeHoldingRegister(request);
+        break;
+    case WRITE_MULT_REGISTERS:
+        response = writeMultipleHoldingRegister(request);
+        break;
+    case R_W_MULT_REGISTERS:
+        response = readWriteMultipleRegister(request);
+        break;
+    case ENCAPSULATED_INTERFACE:
+        response = readDeviceIdentification(request);
+        break;
+    default:
+        response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_FUNCTION);
+        break;
+    }
+    recordStatistic(request.getFunctionCode(), micros() - start, response.getError() != SUCCESS);
+    return response;
+}
+
+/**
+ * Record handler time and exception of function code
+ *
+ * @param[in]   functionCode    function code of the request
+ * @param[in]   time    handler time in us
+ * @param[in]   isException true if exception response is returned
+ */
+void LoadModbusServer::recordStatistic(uint8_t functionCode, uint32_t time, bool isException)
+{
+    size_t index = 0;
+    while (index < _functionCode.size() && _functionCode[index] != functionCode)
+    {
+        index++;
+    }
+    if (index >= _functionCode.size())
+    {
+        return;
+    }
+
+    size_t bucket = 0;
+    while (bucket < LMS_HISTOGRAM_BUCKET - 1 && time >= (16UL << bucket)) //log2 bucket
+    {
+        bucket++;
+    }
+
+    xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+    LoadModbus::function_stat_t &stat = _functionStat[index];
+    stat.request++;
+    if (isException)
+    {
+        stat.exception++;
+    }
+    stat.minTime = time < stat.minTime ? time : stat.minTime;
+    stat.maxTime = time > stat.maxTime ? time : stat.maxTime;
+    stat.totalTime += time;
+    if (stat.histogram[bucket] < UINT16_MAX)
+    {
+        stat.histogram[bucket]++;
+    }
+    xSemaphoreGiveRecursive(_mutex);
+}
+
+/**
+ * Add broadcast address range
+ *
+ * @param[in]   list    broadcast list
+ * @param[in]   address start address
+ * @param[in]   size    number of coil or register
+ *
+ * @return  true if success, false if list is full
+ */
+bool LoadModbusServer::addBroadcast(LoadModbus::broadcast_list_t &list, uint16_t address, uint16_t size)
+{
+    if (list.size >= list.range.size() || size == 0)
+    {
+        return false;
+    }
+    list.range[list.size].address = address;
+    list.range[list.size].size = size;
+    list.size++;
+    return true;
+}
+
+/**
+ * Check if every address in the range accept broadcast write
+ *
+ * @param[in]   list    broadcast list
+ * @param[in]   address start address
+ * @param[in]   count   number of coil or register
+ *
+ * @return  true if allowed
+ */
+bool LoadModbusServer::isBroadcastAllowed(const LoadModbus::broadcast_list_t &list, uint16_t address, uint16_t count)
+{
+    for (size_t i = 0; i < list.size; i++)
+    {
+        const LoadModbus::address_range_t &range = list.range[i];
+        if (address >= range.address && (uint32_t)address + count <= (uint32_t)range.address + range.size)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Accept broadcast write on coil range
+ *
+ * @param[in]   address start address
+ * @param[in]   size    number of coil
+ *
+ * @return  true if success
+ */
+bool LoadModbusServer::addBroadcastCoil(uint16_t address, uint16_t size)
+{
+    return addBroadcast(_broadcastCoil, address, size);
+}
+
+/**
+ * Accept broadcast write on holding register range
+ *
+ * @param[in]   address start address
+ * @param[in]   size    number of register
+ *
+ * @return  true if success
+ */
+bool LoadModbusServer::addBroadcastRegister(uint16_t address, uint16_t size)
+{
+    return addBroadcast(_broadcastRegister, address, size);
+}
+
+/**
+ * Serve broadcast request (server id 0)
+ *
+ * @brief   only FC05, FC0F, FC06 and FC10 on the broadcast address range are executed,
+ *          every other broadcast is ignored. no response is sent for broadcast
+ *
+ * @param[in]   request request message
+ */
+void LoadModbusServer::serveBroadcast(const ModbusMessage &request)
+{
+    uint16_t address = 0;
+    uint16_t count = 1;
+    switch (request.getFunctionCode())
+    {
+    case WRITE_COIL:
+        request.get(2, address);
+        if (isBroadcastAllowed(_broadcastCoil, address, count))
+        {
+            serve(request);
+        }
+        break;
+    case WRITE_MULT_COILS:
+        request.get(2, address, count);
+        if (isBroadcastAllowed(_broadcastCoil, address, count))
+        {
+            serve(request);
+        }
+        break;
+    case WRITE_HOLD_REGISTER:
+        request.get(2, address);
+        if (isBroadcastAllowed(_broadcastRegister, address, count))
+        {
+            serve(request);
+        }
+        break;
+    case WRITE_MULT_REGISTERS:
+        request.get(2, address, count);
+        if (isBroadcastAllowed(_broadcastRegister, address, count))
+        {
+            serve(request);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * Count frame seen on the bus
+ *
+ * @brief   eModbus pass every valid frame into the RTU sniffer before checking the server id,
+ *          frame with wrong crc is dropped by eModbus and is not counted here
+ *
+ * @param[in]   msg frame without crc
+ * @param[in]   serverId    id of this server
+ */
+void LoadModbusServer::countFrame(const ModbusMessage &msg, uint8_t serverId)
+{
+    if (msg.size() < 2)
+    {
+        return;
+    }
+
+    unsigned long now = millis();
+    xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+    _busStat.frame++;
+    if (msg.getServerID() == serverId)
+    {
+        if (_isPolled && _pollTimeout > 0 && now - _lastPoll > _pollTimeout)
+        {
+            _busStat.pollTimeout++;
+        }
+        _lastPoll = now;
+        _isPolled = true;
+    }
+    else if (msg.getServerID() != 0) //broadcast is served by every server
+    {
+        _busStat.otherServer++;
+    }
+    xSemaphoreGiveRecursive(_mutex);
+}
+
+/**
+ * Set poll timeout
+ *
+ * @param[in]   timeout maximum time between request in ms, 0 to disable
+ */
+void LoadModbusServer::setPollTimeout(uint32_t timeout)
+{
+    _pollTimeout = timeout;
+}
+
+/**
+ * Copy diagnostic register
+ *
+ * @brief   register layout
+ *          0 - 1 : valid frame, 2 - 3 : frame to other server, 4 - 5 : poll timeout, 6 : number of function code, 7 : reserved
+ *          8 + 16 * n : function code n statistic
+ *              0 : function code, 1 - 2 : request, 3 - 4 : exception, 5 : min time, 6 : average time, 7 : max time (us)
+ *              8 - 15 : histogram, bucket n count handler time from 2^(n+3) us
+ *
+ * @param[in]   index   first register
+ * @param[in]   count   number of register
+ * @param[out]  buff    register value
+ *
+ * @return  true if success
+ */
+bool LoadModbusServer::readStatistic(uint16_t index, uint16_t count, uint16_t *buff)
+{
+    if ((uint32_t)index + count > LMS_STAT_SIZE)
+    {
+        return false;
+    }
+
+    uint16_t regs[LMS_STAT_SIZE] = {};
+    xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+    regs[0] = _busStat.frame >> 16;
+    regs[1] = _busStat.frame & 0xFFFF;
+    regs[2] = _busStat.otherServer >> 16;
+    regs[3] = _busStat.otherServer & 0xFFFF;
+    regs[4] = _busStat.pollTimeout >> 16;
+    regs[5] = _busStat.pollTimeout & 0xFFFF;
+    regs[6] = LMS_MAX_FUNCTION;
+    for (size_t i = 0; i < LMS_MAX_FUNCTION; i++)
+    {
+        const LoadModbus::function_stat_t &stat = _functionStat[i];
+        uint16_t *reg = regs + LMS_STAT_HEADER_SIZE + i * LMS_STAT_FUNCTION_SIZE;
+        uint32_t average = stat.request ? stat.totalTime / stat.request : 0;
+        reg[0] = _functionCode[i];
+        reg[1] = stat.request >> 16;
+        reg[2] = stat.request & 0xFFFF;
+        reg[3] = stat.exception >> 16;
+        reg[4] = stat.exception & 0xFFFF;
+        reg[5] = stat.request ? (stat.minTime > UINT16_MAX ? UINT16_MAX : stat.minTime) : 0;
+        reg[6] = average > UINT16_MAX ? UINT16_MAX : average;
+        reg[7] = stat.maxTime > UINT16_MAX ? UINT16_MAX : stat.maxTime;
+        memcpy(reg + 8, stat.histogram.data(), LMS_HISTOGRAM_BUCKET * sizeof(uint16_t));
+    }
+    xSemaphoreGiveRecursive(_mutex);
+    memcpy(buff, regs + index, count * sizeof(uint16_t));
+    return true;
+}
+
+/**
+ * Reset all function code and bus statistic
+ */
+void LoadModbusServer::resetStatistic()
+{
+    xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+    _functionStat.fill(LoadModbus::function_stat_t());
+    _busStat = LoadModbus::bus_stat_t();
+    _isPolled = false;
+    xSemaphoreGiveRecursive(_mutex);
+}
+
+/**
+ * Register all function code handler into modbus server
+ *
+ * @param[in]   server  modbus server (RTU or TCP)
+ * @param[in]   serverId    id of the server
+ */
+void LoadModbusServer::registerWorker(ModbusServer &server, uint8_t serverId)
+{
+    for (uint8_t functionCode : _functionCode)
+    {
+        server.registerWorker(serverId, functionCode, [this](const ModbusMessage &request) { return serve(request); });
+    }
+}
+
+LoadModbusServer::~LoadModbusServer()
+{
+    vSemaphoreDelete(_mutex);
+}
@@ -0,0 +1,175 @@
+#ifndef LOAD_MODBUS_SERVER_H
+#define LOAD_MODBUS_SERVER_H
+
+#include <Arduino.h>
+#include <array>
+#include <functional>
+#include <ModbusServer.h>
+#include <CoilData.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#define LMS_MAX_BLOCK 10 //maximum number of register block for each register type
+#define LMS_MAX_READ_REGISTER 125 //maximum register for single read request
+#define LMS_MAX_WRITE_REGISTER 123 //maximum register for single write request
+#define LMS_MAX_COIL 256 //maximum coil for single request
+#define LMS_MAX_FRAME 256 //maximum response frame without crc
+#define LMS_MAX_RW_WRITE_REGISTER 121 //maximum register written by single read/write request
+#define LMS_MAX_DEVICE_OBJECT 16 //maximum device identification object
+#define LMS_MAX_BROADCAST 8 //maximum address range accepting broadcast write for each type
+#define LMS_MAX_FUNCTION 9 //number of served function code
+#define LMS_HISTOGRAM_BUCKET 8 //handler time histogram, bucket n count time from 2^(n+3) us, first bucket below 16 us
+#define LMS_STAT_HEADER_SIZE 8 //diagnostic header register
+#define LMS_STAT_FUNCTION_SIZE 16 //diagnostic register for each function code
+#define LMS_STAT_SIZE (LMS_STAT_HEADER_SIZE + LMS_MAX_FUNCTION * LMS_STAT_FUNCTION_SIZE) //diagnostic register block size
+
+namespace LoadModbus {
+    using ReadHandler = std::function<bool(uint16_t index, uint16_t count, uint16_t *buff)>; //copy count register start from index into buff
+    using WriteHandler = std::function<bool(uint16_t index, uint16_t count, uint16_t *buff)>; //write count register from buff start at index
+    using CoilHandler = std::function<bool(uint16_t index, bool value)>; //return true if coil write is consumed, false to store into coil
+
+    /**
+     * register block, contiguous address range served by single read and write handler
+     */
+    struct register_block_t {
+        uint16_t address = 0; //start address
+        uint16_t size = 0; //number of register
+        ReadHandler read; //read handler
+        WriteHandler write; //write handler, leave empty for read only block
+    };
+
+    /**
+     * register table, fixed number of block sorted by address
+     */
+    struct register_table_t {
+        std::array<register_block_t, LMS_MAX_BLOCK> block;
+        size_t size = 0;
+    };
+
+    /**
+     * device identification object id, 0x80 - 0xFF are product specific extended object
+     */
+    enum DeviceObject : uint8_t {
+        VENDOR_NAME = 0x00,
+        PRODUCT_CODE = 0x01,
+        MAJOR_MINOR_REVISION = 0x02,
+        VENDOR_URL = 0x03,
+        PRODUCT_NAME = 0x04,
+        MODEL_NAME = 0x05,
+        USER_APPLICATION_NAME = 0x06,
+        EXTENDED_OBJECT = 0x80
+    };
+
+    /**
+     * address range
+     */
+    struct address_range_t {
+        uint16_t address = 0; //start address
+        uint16_t size = 0; //number of coil or register
+    };
+
+    /**
+     * list of address range accepting broadcast write
+     */
+    struct broadcast_list_t {
+        std::array<address_range_t, LMS_MAX_BROADCAST> range;
+        size_t size = 0;
+    };
+
+    /**
+     * request statistic of single function code
+     */
+    struct function_stat_t {
+        uint32_t request = 0; //number of served request
+        uint32_t exception = 0; //number of exception response
+        uint32_t minTime = UINT32_MAX; //minimum handler time in us
+        uint32_t maxTime = 0; //maximum handler time in us
+        uint64_t totalTime = 0; //sum of handler time in us
+        std::array<uint16_t, LMS_HISTOGRAM_BUCKET> histogram = {}; //saturating counter
+    };
+
+    /**
+     * bus statistic, counted from every frame seen on the bus
+     */
+    struct bus_stat_t {
+        uint32_t frame = 0; //number of valid frame
+        uint32_t otherServer = 0; //frame addressed to other server
+        uint32_t pollTimeout = 0; //master did not poll this server within poll timeout
+    };
+
+    /**
+     * device identification object, value must stay valid for the lifetime of the server
+     */
+    struct device_object_t {
+        uint8_t id = 0;
+        const char* value = NULL;
+    };
+};
+
+/**
+ * Modbus function code handler shared by all load control program
+ *
+ * @brief   address is decoded through the register table, response frame is built on stack buffer. every response cost
+ *          one allocation, the returned ModbusMessage, which the eModbus worker API requires. call registerWorker once to attach FC01, FC05, FC0F, FC03, FC04, FC06, FC10, FC17 and FC2B/0E into the server.
+ *          the same handler can be registered into several server (RTU and TCP), table access is serialized by mutex
+ */
+class LoadModbusServer
+{
+private:
+    /* data */
+    const char* _TAG = "load-modbus-server";
+    LoadModbus::register_table_t _holdingTable;
+    LoadModbus::register_table_t _inputTable;
+    CoilData *_coils = NULL;
+    uint16_t _coilAddress = 0;
+    LoadModbus::CoilHandler _coilHandler;
+    std::array<LoadModbus::device_object_t, LMS_MAX_DEVICE_OBJECT> _deviceObject;
+    size_t _deviceObjectSize = 0;
+    static const std::array<uint8_t, LMS_MAX_FUNCTION> _functionCode;
+    std::array<LoadModbus::function_stat_t, LMS_MAX_FUNCTION> _functionStat;
+    LoadModbus::bus_stat_t _busStat;
+    LoadModbus::broadcast_list_t _broadcastCoil;
+    LoadModbus::broadcast_list_t _broadcastRegister;
+    uint32_t _pollTimeout = 0;
+    unsigned long _lastPoll = 0;
+    bool _isPolled = false;
+    SemaphoreHandle_t _mutex = NULL;
+    bool addBlock(LoadModbus::register_table_t &table, uint16_t address, uint16_t size, LoadModbus::ReadHandler read, LoadModbus::WriteHandler write); //insert block sorted by address
+    Error readTable(const LoadModbus::register_table_t &table, uint16_t address, uint16_t count, uint16_t *buff); //read range across block
+    Error writeTable(const LoadModbus::register_table_t &table, uint16_t address, uint16_t count, uint16_t *buff); //write range across block
+    bool writeCoilValue(uint16_t index, bool value); //pass coil into handler, then store it
+    ModbusMessage buildResponse(const uint8_t *frame, uint16_t len); //build response in single allocation
+    ModbusMessage buildRegisterResponse(const ModbusMessage &request, uint16_t count, const uint16_t *buff); //build read register response
+    ModbusMessage serve(const ModbusMessage &request); //dispatch request and record statistic
+    void recordStatistic(uint8_t functionCode, uint32_t time, bool isException); //record handler time and exception
+    bool addBroadcast(LoadModbus::broadcast_list_t &list, uint16_t address, uint16_t size); //add broadcast address range
+    bool isBroadcastAllowed(const LoadModbus::broadcast_list_t &list, uint16_t address, uint16_t count); //check if whole range accept broadcast
+public:
+    LoadModbusServer();
+    bool addHoldingRegister(uint16_t address, uint16_t size, LoadModbus::ReadHandler read, LoadModbus::WriteHandler write = nullptr); //add holding register block
+    bool addInputRegister(uint16_t address, uint16_t size, LoadModbus::ReadHandler read); //add input register block
+    void setCoil(uint16_t address, CoilData *coils); //set coil storage and its start address
+    void setCoilHandler(LoadModbus::CoilHandler handler); //set handler called before coil is stored
+    bool setDeviceObject(uint8_t id, const char* value); //set device identification object
+    void registerWorker(ModbusServer &server, uint8_t serverId); //register all function code into server
+    bool addBroadcastCoil(uint16_t address, uint16_t size); //accept broadcast write on coil range
+    bool addBroadcastRegister(uint16_t address, uint16_t size); //accept broadcast write on holding register range
+    void serveBroadcast(const ModbusMessage &request); //serve broadcast write, no response is sent
+    void countFrame(const ModbusMessage &msg, uint8_t serverId); //count frame seen on the bus, call from sniffer
+    void setPollTimeout(uint32_t timeout); //set maximum time between request before poll timeout is counted
+    bool readStatistic(uint16_t index, uint16_t count, uint16_t *buff); //copy diagnostic register
+    void resetStatistic(); //reset all statistic
+
+    ModbusMessage readCoil(const ModbusMessage &request); //FC01
+    ModbusMessage writeCoil(const ModbusMessage &request); //FC05
+    ModbusMessage writeMultipleCoil(const ModbusMessage &request); //FC0F
+    ModbusMessage readHoldingRegister(const ModbusMessage &request); //FC03
+    ModbusMessage readInputRegister(const ModbusMessage &request); //FC04
+    ModbusMessage writeHoldingRegister(const ModbusMessage &request); //FC06
+    ModbusMessage writeMultipleHoldingRegister(const ModbusMessage &request); //FC10
+    ModbusMessage readWriteMultipleRegister(const ModbusMessage &request); //FC17
+    ModbusMessage readDeviceIdentification(const ModbusMessage &request); //FC2B MEI 0E
+    ~LoadModbusServer();
+};
+
+#endif
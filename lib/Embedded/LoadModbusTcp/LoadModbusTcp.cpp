@@ -0,0 +1,112 @@
+#include "LoadModbusTcp.h"
+
+LoadModbusTcp::LoadModbusTcp()
+{
+}
+
+/**
+ * Start W5x00 with stored network setting
+ *
+ * @param[in]   ethernetSave    stored network setting, must be started with begin
+ * @param[in]   config  pin config, refer to modbus_tcp_config_t
+ *
+ * @return  true if ethernet is started
+ */
+bool LoadModbusTcp::beginEthernet(EthernetSave &ethernetSave, const LoadModbus::modbus_tcp_config_t &config)
+{
+    const char* _TAG = "load-modbus-tcp";
+    uint8_t mac[6];
+    if (ethernetSave.getMac(mac, sizeof(mac)) != sizeof(mac))
+    {
+        ESP_LOGE(_TAG, "ethernet setting is not started");
+        return false;
+    }
+
+    SPI.begin(config.sckPin, config.misoPin, config.mosiPin, config.csPin);
+    Ethernet.init(config.csPin);
+
+    if (ethernetSave.getServer() == server_type::DHCP)
+    {
+        if (!Ethernet.begin(mac))
+        {
+            ESP_LOGE(_TAG, "failed to get ip from dhcp");
+            return false;
+        }
+    }
+    else
+    {
+        IPAddress ip;
+        IPAddress gateway;
+        IPAddress subnet;
+        ip.fromString(ethernetSave.getIp().c_str());
+        gateway.fromString(ethernetSave.getGateway().c_str());
+        subnet.fromString(ethernetSave.getSubnet().c_str());
+        Ethernet.begin(mac, ip, gateway, gateway, subnet);
+    }
+
+    if (Ethernet.hardwareStatus() == EthernetNoHardware)
+    {
+        ESP_LOGE(_TAG, "ethernet hardware not found");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Start ethernet and modbus tcp server
+ *
+ * @param[in]   ethernetSave    stored network setting, must be started with begin
+ * @param[in]   handler function code handler shared with RTU server
+ * @param[in]   serverId    id of the server
+ * @param[in]   config  pin and server config, refer to modbus_tcp_config_t
+ *
+ * @return  true if server is started
+ */
+bool LoadModbusTcp::begin(EthernetSave &ethernetSave, LoadModbusServer &handler, uint8_t serverId, const LoadModbus::modbus_tcp_config_t &config)
+{
+    if (!beginEthernet(ethernetSave, config))
+    {
+        return false;
+    }
+
+    handler.registerWorker(_server, serverId);
+    _isStarted = _server.start(config.port, config.maxClient, config.idleTimeout, config.coreId);
+    ESP_LOGI(_TAG, "modbus tcp on %s:%d, started = %d\n", Ethernet.localIP().toString().c_str(), config.port, _isStarted);
+    return _isStarted;
+}
+
+/**
+ * Stop modbus tcp server
+ */
+void LoadModbusTcp::stop()
+{
+    if (_isStarted)
+    {
+        _server.stop();
+        _isStarted = false;
+    }
+}
+
+/**
+ * Get number of connected client
+ *
+ * @return  number of active client
+ */
+uint16_t LoadModbusTcp::getActiveClient()
+{
+    return _server.activeClients();
+}
+
+/**
+ * Get server state
+ *
+ * @return  true if server is running
+ */
+bool LoadModbusTcp::isStarted()
+{
+    return _isStarted;
+}
+
+LoadModbusTcp::~LoadModbusTcp()
+{
+}
@@ -0,0 +1,50 @@
+#ifndef LOAD_MODBUS_TCP_H
+#define LOAD_MODBUS_TCP_H
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <Ethernet.h>
+#include <ModbusServerEthernet.h>
+#include <EthernetSave.h>
+#include <LoadModbusServer.h>
+
+namespace LoadModbus {
+    /**
+     * config struct for modbus tcp server
+     */
+    struct modbus_tcp_config_t {
+        int sckPin = 14; //spi clock to W5x00
+        int misoPin = 35; //spi miso from W5x00
+        int mosiPin = 4; //spi mosi to W5x00
+        int csPin = 5; //chip select of W5x00
+        uint16_t port = 502; //modbus tcp port
+        uint8_t maxClient = 4; //maximum concurrent client, each client served by its own task
+        uint32_t idleTimeout = 20000; //close idle client connection after this time in ms
+        int coreId = -1; //core to run the server task, -1 for any core
+    };
+};
+
+/**
+ * Modbus TCP server on W5x00 ethernet
+ *
+ * @brief   serve the same register table and coil as the RTU server through LoadModbusServer,
+ *          network setting is taken from EthernetSave
+ */
+class LoadModbusTcp
+{
+private:
+    /* data */
+    const char* _TAG = "load-modbus-tcp";
+    ModbusServerEthernet _server;
+    bool _isStarted = false;
+public:
+    LoadModbusTcp();
+    static bool beginEthernet(EthernetSave &ethernetSave, const LoadModbus::modbus_tcp_config_t &config); //start W5x00 with stored network setting
+    bool begin(EthernetSave &ethernetSave, LoadModbusServer &handler, uint8_t serverId, const LoadModbus::modbus_tcp_config_t &config); //start ethernet and modbus tcp server
+    void stop(); //stop modbus tcp server
+    uint16_t getActiveClient(); //get number of connected client
+    bool isStarted(); //get server state
+    ~LoadModbusTcp();
+};
+
+#endif
@@ -8,27 +8,56 @@ LoadParameter::LoadParameter(/* args */)
  * begin the preference namespace, write the default setting and init flag
  * 
  * @param[in]   name    name for preference namespace
+ * @param[in]   fastBoot    true to load shadow register and extra parameter from single blob read and print parameter in background task
 */
-void LoadParameter::begin(String name)
+void LoadParameter::begin(String name, bool fastBoot)
 {
     Preferences preferences;
     preferences.begin(name.c_str());
     _name = name;
+    bool isUserChanged = false;
     if (!preferences.isKey("init_flg")) // get init flag to detect the first time init
     {
         ESP_LOGI(_TAG, "Create default");
         createDefault();
         copy();
+        isUserChanged = true;
     }
     if (preferences.getBool("rst_flg")) // get reset flag to revert the user parameter into default
     {
         ESP_LOGI(_TAG, "Revert to default");
         copy();
         preferences.putBool("rst_flg", false);
+        isUserChanged = true;
     }
-    printDefault();
-    printUser();
-    writeShadow();
+    preferences.end();
+
+    if (!fastBoot)
+    {
+        printDefault();
+        printUser();
+        writeShadow();
+        return;
+    }
+
+    if (isUserChanged || !readShadowBlob()) // user parameter is changed or blob is not exist, fallback into per key read
+    {
+        writeShadow();
+    }
+    xTaskCreate(&LoadParameter::printTask, "lp print task", 3072, this, 1, NULL); //print parameter with lowest priority
+}
+
+/**
+ * Task to print default and user parameter, delete itself when finished
+ * 
+ * @param[in]   pvParameter pointer to LoadParameter object
+ */
+void LoadParameter::printTask(void *pvParameter)
+{
+    LoadParameter *lp = static_cast<LoadParameter*>(pvParameter);
+    lp->printDefault();
+    lp->printUser();
+    vTaskDelete(NULL);
 }
 
 /**
@@ -75,13 +104,16 @@ void LoadParameter::createDefault()
     preferences.putUShort("d_sc_dt3", 10);    // default short circuit detection time
     preferences.putUShort("d_sc_rt3", 4000);    // default short circuit reconnect time
     preferences.putUShort("d_om_3", 0);    // default output mode
+    putChannelDefault(preferences, "opd", {0, 0, 0});    // default overpower disconnect, disabled
+    putChannelDefault(preferences, "win", {1, 60, 900});    // default statistic window in seconds
+    putChannelDefault(preferences, "ovs", {1, 1, 1});    // default current oversampling, latest block only
     preferences.putBool("init_flg", true);
     preferences.putBool("rst_flg", false);
     preferences.end();
 }
 
 /**
- * copy default parameter into user parameter
+ * copy default parameter into user parameter, learned current offset (u_cof) has no default and is kept
 */
 void LoadParameter::copy()
 {
@@ -124,9 +156,48 @@ void LoadParameter::copy()
     preferences.putUShort("u_sc_dt3", preferences.getUShort("d_sc_dt3"));    
     preferences.putUShort("u_sc_rt3", preferences.getUShort("d_sc_rt3"));   
     preferences.putUShort("u_om_3", preferences.getUShort("d_om_3"));
+    copyChannelDefault(preferences, "opd", {0, 0, 0});
+    copyChannelDefault(preferences, "win", {1, 60, 900});
+    copyChannelDefault(preferences, "ovs", {1, 1, 1});
     preferences.end();
 }
 
+/**
+ * create default of per channel key d_<name>1 - d_<name>3
+ * 
+ * @param[in]   preferences opened preferences
+ * @param[in]   name    key name without prefix and channel number
+ * @param[in]   value   default value of each channel
+*/
+void LoadParameter::putChannelDefault(Preferences &preferences, const char *name, const std::array<uint16_t, 3> &value)
+{
+    for (size_t i = 0; i < value.size(); i++)
+    {
+        char key[8];
+        snprintf(key, sizeof(key), "d_%s%d", name, (int)(i + 1));
+        preferences.putUShort(key, value[i]);
+    }
+}
+
+/**
+ * copy default of per channel key d_<name>1 - d_<name>3 into u_<name>1 - u_<name>3
+ * 
+ * @param[in]   preferences opened preferences
+ * @param[in]   name    key name without prefix and channel number
+ * @param[in]   fallback    default used when the default key is not created yet (default created by older firmware)
+*/
+void LoadParameter::copyChannelDefault(Preferences &preferences, const char *name, const std::array<uint16_t, 3> &fallback)
+{
+    for (size_t i = 0; i < fallback.size(); i++)
+    {
+        char defaultKey[8];
+        char userKey[8];
+        snprintf(defaultKey, sizeof(defaultKey), "d_%s%d", name, (int)(i + 1));
+        snprintf(userKey, sizeof(userKey), "u_%s%d", name, (int)(i + 1));
+        preferences.putUShort(userKey, preferences.getUShort(defaultKey, fallback[i]));
+    }
+}
+
 /**
  * write into shadow register
 */
@@ -174,6 +245,67 @@ void LoadParameter::writeShadow()
     _shadowRegisters[33] = preferences.getUShort("u_sc_rt3");
     _shadowRegisters[34] = preferences.getUShort("u_om_3");
 
+    const LoadExtraParameter fallback; //key is not created before the parameter is written
+    _extra.group = preferences.getUShort("u_group", fallback.group);
+    for (size_t i = 0; i < 3; i++)
+    {
+        char key[8];
+        snprintf(key, sizeof(key), "u_opd%d", (int)(i + 1));
+        _extra.overpower[i] = preferences.getUShort(key, fallback.overpower[i]);
+        snprintf(key, sizeof(key), "u_win%d", (int)(i + 1));
+        _extra.statWindow[i] = preferences.getUShort(key, fallback.statWindow[i]);
+        snprintf(key, sizeof(key), "u_cof%d", (int)(i + 1));
+        _extra.currentOffset[i] = preferences.getShort(key, fallback.currentOffset[i]);
+        snprintf(key, sizeof(key), "u_ovs%d", (int)(i + 1));
+        _extra.oversampling[i] = preferences.getUShort(key, fallback.oversampling[i]);
+    }
+
+    preferences.end();
+    writeShadowBlob();
+}
+
+/**
+ * read shadow register and extra parameter from blob key, single read for all user parameter
+ * 
+ * @return  true if blob exist and has the same size as boot record
+*/
+bool LoadParameter::readShadowBlob()
+{
+    Preferences preferences;
+    preferences.begin(_name.c_str(), true);
+    LoadBootRecord record;
+    if (preferences.getBytesLength("u_blob") != sizeof(record)) //blob of older firmware hold shadow register only
+    {
+        preferences.end();
+        return false;
+    }
+    bool isSuccess = preferences.getBytes("u_blob", &record, sizeof(record)) == sizeof(record);
+    preferences.end();
+    if (isSuccess)
+    {
+        _shadowRegisters = record.shadow;
+        _extra = record.extra;
+    }
+    return isSuccess;
+}
+
+/**
+ * write shadow register and extra parameter into blob key, only written when the content is different to save flash cycle
+*/
+void LoadParameter::writeShadowBlob()
+{
+    LoadBootRecord record;
+    record.shadow = _shadowRegisters;
+    record.extra = _extra;
+    LoadBootRecord stored;
+    Preferences preferences;
+    preferences.begin(_name.c_str());
+    if (preferences.getBytesLength("u_blob") != sizeof(record) || 
+        preferences.getBytes("u_blob", &stored, sizeof(stored)) != sizeof(stored) || 
+        memcmp(&stored, &record, sizeof(record)) != 0)
+    {
+        preferences.putBytes("u_blob", &record, sizeof(record));
+    }
     preferences.end();
 }
 
@@ -376,9 +508,20 @@ uint16_t LoadParameter::getBaudrate()
 }
 
 /**
- * get baud rate in bps value (9600 - 115200)
+ * check if baud rate is detected from master request
+ * 
+ * @return  true if baud rate code is BAUDRATE_AUTO
+*/
+bool LoadParameter::isAutoBaudrate()
+{
+    return _shadowRegisters[0] == BAUDRATE_AUTO;
+}
+
+/**
+ * get baud rate in bps value (9600 - 921600)
  * 
- * @return  baud rate in bps
+ * @return  baud rate in bps, 9600 for auto baud or unknown code so the uart is never started at 0 bps.
+ *          target supporting auto baud check isAutoBaudrate first
 */
 int LoadParameter::getBaudrateBps()
 {
@@ -406,10 +549,19 @@ int LoadParameter::getBaudrateBps()
     case 6:
         return 115200;
         break;    
+    case 7:
+        return 230400;
+        break;
+    case 8:
+        return 460800;
+        break;
+    case 9:
+        return 921600;
+        break;
     default:
         break;
     }
-    return 0;
+    return 9600;
 }
 
 /**
@@ -422,6 +574,69 @@ uint16_t LoadParameter::getId()
     return _shadowRegisters[1];
 }
 
+/**
+ * get broadcast group mask
+ * 
+ * @return  group mask, bit n is set if the device is member of group n
+*/
+uint16_t LoadParameter::getGroup()
+{
+    return _extra.group;
+}
+
+/**
+ * get overpower disconnect
+ * 
+ * @param[in]   channel load channel (0 - 2)
+ * 
+ * @return  overpower disconnect in 0.1W, 0 if disabled
+*/
+uint16_t LoadParameter::getOverpowerDisconnect(size_t channel)
+{
+    return channel < _extra.overpower.size() ? _extra.overpower[channel] : 0;
+}
+
+/**
+ * get statistic window length
+ * 
+ * @param[in]   level   window level (0 - 2)
+ * 
+ * @return  window length in seconds, 0 if the level is disabled
+*/
+uint16_t LoadParameter::getStatWindow(size_t level)
+{
+    return level < _extra.statWindow.size() ? _extra.statWindow[level] : 0;
+}
+
+/**
+ * get learned current sensor zero offset
+ * 
+ * @param[in]   channel current channel (0 - 2)
+ * @param[in]   defaultValue    offset returned if nothing is learned yet
+ * 
+ * @return  offset from sensor midpoint in mV
+*/
+int16_t LoadParameter::getCurrentOffset(size_t channel, int16_t defaultValue)
+{
+    if (channel >= _extra.currentOffset.size() || _extra.currentOffset[channel] == INT16_MIN)
+    {
+        return defaultValue;
+    }
+    return _extra.currentOffset[channel];
+}
+
+/**
+ * get current oversampling
+ * 
+ * @param[in]   channel current channel (0 - 2)
+ * 
+ * @return  number of current block averaged into extended resolution value
+*/
+uint16_t LoadParameter::getOversampling(size_t channel)
+{
+    return channel < _extra.oversampling.size() ? _extra.oversampling[channel] : 1;
+}
+
 /**
  * get load 1 overvoltage disconnect
  * 
@@ -770,6 +985,16 @@ size_t LoadParameter::getAllParameter(loadParamRegister &regs)
     return paramNumber;
 }
 
+/**
+ * get shadow register
+ * 
+ * @return  reference to live shadow register, updated on every write
+ */
+const loadParamRegister& LoadParameter::getShadowRegister()
+{
+    return _shadowRegisters;
+}
+
 
 /**
  * ============================================================
@@ -782,7 +1007,7 @@ size_t LoadParameter::getAllParameter(loadParamRegister &regs)
  */
 void LoadParameter::setBaudrate(uint16_t value)
 {
-    if (value < 0 || value > 6)
+    if (value < 0 || value > BAUDRATE_AUTO)
     {
         return;
     }
@@ -811,6 +1036,114 @@ void LoadParameter::setId(uint16_t value)
     ESP_LOGI(_TAG, "set id to %d\n", value);
 }
 
+/**
+ * save broadcast group mask into flash, take effect immediately
+ * 
+ * @param[in]   value   group mask, bit n for group n
+ */
+void LoadParameter::setGroup(uint16_t value)
+{
+    _extra.group = value;
+    Preferences preferences;
+    preferences.begin(_name.c_str());
+    preferences.putUShort("u_group", value);
+    preferences.end();
+    writeShadowBlob(); //keep the boot record in sync
+    ESP_LOGI(_TAG, "set group to 0x%04X\n", value);
+}
+
+/**
+ * save overpower disconnect into flash
+ * 
+ * @param[in]   channel load channel (0 - 2)
+ * @param[in]   value   overpower disconnect in 0.1W, 0 to disable
+ */
+void LoadParameter::setOverpowerDisconnect(size_t channel, uint16_t value)
+{
+    if (channel >= _extra.overpower.size())
+    {
+        return;
+    }
+    _extra.overpower[channel] = value;
+    char key[8];
+    snprintf(key, sizeof(key), "u_opd%d", (int)(channel + 1));
+    Preferences preferences;
+    preferences.begin(_name.c_str());
+    preferences.putUShort(key, value);
+    preferences.end();
+    writeShadowBlob(); //keep the boot record in sync
+    ESP_LOGI(_TAG, "set overpower disconnect %d to %d\n", channel + 1, value);
+}
+
+/**
+ * save statistic window length into flash
+ * 
+ * @param[in]   level   window level (0 - 2)
+ * @param[in]   value   window length in seconds, 0 to disable the level
+ */
+void LoadParameter::setStatWindow(size_t level, uint16_t value)
+{
+    if (level >= _extra.statWindow.size())
+    {
+        return;
+    }
+    _extra.statWindow[level] = value;
+    char key[8];
+    snprintf(key, sizeof(key), "u_win%d", (int)(level + 1));
+    Preferences preferences;
+    preferences.begin(_name.c_str());
+    preferences.putUShort(key, value);
+    preferences.end();
+    writeShadowBlob(); //keep the boot record in sync
+    ESP_LOGI(_TAG, "set statistic window %d to %d s\n", level + 1, value);
+}
+
+/**
+ * save learned current sensor zero offset into flash
+ * 
+ * @param[in]   channel current channel (0 - 2)
+ * @param[in]   value   offset from sensor midpoint in mV
+ */
+void LoadParameter::setCurrentOffset(size_t channel, int16_t value)
+{
+    if (channel >= _extra.currentOffset.size())
+    {
+        return;
+    }
+    _extra.currentOffset[channel] = value;
+    char key[8];
+    snprintf(key, sizeof(key), "u_cof%d", (int)(channel + 1));
+    Preferences preferences;
+    preferences.begin(_name.c_str());
+    preferences.putShort(key, value);
+    preferences.end();
+    writeShadowBlob(); //keep the boot record in sync
+    ESP_LOGI(_TAG, "set current offset %d to %d mV\n", channel + 1, value);
+}
+
+/**
+ * save current oversampling into flash
+ * 
+ * @param[in]   channel current channel (0 - 2)
+ * @param[in]   value   number of current block averaged into extended resolution value
+ */
+void LoadParameter::setOversampling(size_t channel, uint16_t value)
+{
+    if (channel >= _extra.oversampling.size())
+    {
+        return;
+    }
+    _extra.oversampling[channel] = value;
+    char key[8];
+    snprintf(key, sizeof(key), "u_ovs%d", (int)(channel + 1));
+    Preferences preferences;
+    preferences.begin(_name.c_str());
+    preferences.putUShort(key, value);
+    preferences.end();
+    writeShadowBlob(); //keep the boot record in sync
+    ESP_LOGI(_TAG, "set current oversampling %d to %d block\n", channel + 1, value);
+}
+
 /**
  * save overvoltage disconnect 1 into flash
  * 
@@ -9,6 +9,14 @@
 #include <vector>
 #include "LittleFS.h"
 
+/**
+ * Baudrate code
+ * 
+ * 0 : 9600, 1 : 14400, 2 : 19200, 3 : 28800, 4 : 38400, 5 : 57600, 6 : 115200
+ * 7 : 230400, 8 : 460800, 9 : 921600, 10 : auto, detected from first valid request
+ */
+#define BAUDRATE_AUTO 10
+
 typedef std::array<uint16_t, 35> loadParamRegister;
 
 struct LoadParameterData {
@@ -37,6 +45,26 @@ struct LoadParameterData {
     // uint16_t overcurrentReconnectInterval3 = 4000; // 4000 ms = 4s
 };
 
+/**
+ * Parameter outside the shadow register, stored per key and loaded together with the shadow register
+ * from the single boot record
+ */
+struct LoadExtraParameter {
+    uint16_t group = 0; //broadcast group membership, bit n for group n
+    std::array<uint16_t, 3> overpower = {0, 0, 0}; //overpower disconnect of each load in 0.1W, 0 is disabled
+    std::array<uint16_t, 3> statWindow = {1, 60, 900}; //statistic window length of each level in seconds
+    std::array<int16_t, 3> currentOffset = {INT16_MIN, INT16_MIN, INT16_MIN}; //learned current sensor zero offset in mV, INT16_MIN if not stored
+    std::array<uint16_t, 3> oversampling = {1, 1, 1}; //current block averaged into extended resolution value
+};
+
+/**
+ * Boot record, shadow register and extra parameter stored in single blob key so fast boot is a single read
+ */
+struct LoadBootRecord {
+    loadParamRegister shadow;
+    LoadExtraParameter extra;
+};
+
 class LoadParameter
 {
 private:
@@ -49,10 +77,16 @@ private:
         600, 580, 508, 515, 1500, 500, 4000, 2000, 10, 4000, 0
     };
     String _name;
+    LoadExtraParameter _extra; //parameter outside the shadow register
     void checkUpdatedValue(size_t buffSize, uint16_t* inputParam, uint16_t* deviceParam); //check if there is updated value
     void copy(); //copy from default to user defined parameter
+    void putChannelDefault(Preferences &preferences, const char *name, const std::array<uint16_t, 3> &value); //create default of per channel key
+    void copyChannelDefault(Preferences &preferences, const char *name, const std::array<uint16_t, 3> &fallback); //copy default of per channel key into user key
     void createDefault(); //create default parameter
-    void writeShadow(); //write parameter into shadow register
+    void writeShadow(); //write parameter into shadow register and extra parameter
+    bool readShadowBlob(); //read shadow register and extra parameter from single blob key
+    void writeShadowBlob(); //write shadow register and extra parameter into single blob key
+    static void printTask(void *pvParameter); //background task to print parameter
     void resetWriteFlag(); //reset write flag
 
     void setBaudrate(uint16_t value); //save baudrate into flash
@@ -100,7 +134,7 @@ public:
     void printUser(); //print user parameter from flash
     void printShadow(); //print shadow register
 
-    void begin(String name); //begin littelfs namespace
+    void begin(String name, bool fastBoot = false); //begin littelfs namespace, fast boot load shadow in single read and print in background
     void save(); //perform save from shadow register to flash
     void reset(); //reset
     void restart(); //restart littlefs
@@ -109,9 +143,20 @@ public:
     void writeSingle(size_t index, uint16_t value); //write single register
     size_t writeMultiple(size_t startIndex, size_t buffSize, uint16_t *buff); //write multiple parameter
 
-    uint16_t getBaudrate(); //get baudrate (0 - 6)
-    int getBaudrateBps(); //get baudrate in bps value
+    uint16_t getBaudrate(); //get baudrate (0 - 10)
+    int getBaudrateBps(); //get baudrate in bps value, 9600 for auto baud
+    bool isAutoBaudrate(); //check if baudrate is detected from master, only program-latch support it
     uint16_t getId(); //get id from flash
+    uint16_t getGroup(); //get broadcast group mask
+    void setGroup(uint16_t value); //save broadcast group mask into flash
+    uint16_t getOverpowerDisconnect(size_t channel); //get overpower disconnect of load channel (0 - 2)
+    void setOverpowerDisconnect(size_t channel, uint16_t value); //save overpower disconnect of load channel into flash
+    uint16_t getStatWindow(size_t level); //get statistic window length of level (0 - 2) in seconds
+    void setStatWindow(size_t level, uint16_t value); //save statistic window length of level into flash
+    int16_t getCurrentOffset(size_t channel, int16_t defaultValue); //get learned current sensor zero offset of channel (0 - 2)
+    void setCurrentOffset(size_t channel, int16_t value); //save learned current sensor zero offset of channel into flash
+    uint16_t getOversampling(size_t channel); //get current oversampling of channel (0 - 2) in block
+    void setOversampling(size_t channel, uint16_t value); //save current oversampling of channel into flash
     uint16_t getOvervoltageDisconnect1(); //get overvoltage disconnect 1 from flash
     uint16_t getOvervoltageReconnect1(); //get overvoltage reconnect 1 from flash
     uint16_t getUndervoltageDisconnect1(); //get overvoltage undervoltage 1 from flash
@@ -149,6 +194,7 @@ public:
     uint16_t getOutputMode3();
 
     size_t getAllParameter(loadParamRegister &regs); //get all stored parameter
+    const loadParamRegister& getShadowRegister(); //get reference to shadow register without copy
 
     ~LoadParameter();
 };
@@ -0,0 +1,135 @@
+#include "RelayCommand.h"
+
+RelayCommand::RelayCommand()
+{
+}
+
+/**
+ * Create command queue and mutex
+ */
+void RelayCommand::begin()
+{
+    _queue = xQueueCreate(RC_QUEUE_SIZE, sizeof(LoadModbus::relay_command_t));
+    _mutex = xSemaphoreCreateMutex();
+}
+
+/**
+ * Queue relay command
+ *
+ * @param[in]   relay   relay index
+ * @param[in]   isAccepted  false to record the command as failed without executing it
+ *
+ * @return  command sequence
+ */
+uint16_t RelayCommand::push(uint8_t relay, bool isAccepted)
+{
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    _sequence = _sequence == UINT16_MAX ? 1 : _sequence + 1; //0 is reserved for empty slot
+    LoadModbus::relay_command_t &command = _history[_sequence % RC_MAX_HISTORY];
+    command.sequence = _sequence;
+    command.relay = relay;
+    command.state = LoadModbus::CMD_QUEUED;
+    if (!isAccepted || xQueueSend(_queue, &command, 0) != pdTRUE)
+    {
+        command.state = LoadModbus::CMD_FAILED;
+    }
+    uint16_t sequence = _sequence;
+    LoadModbus::CommandState state = command.state;
+    xSemaphoreGive(_mutex);
+    ESP_LOGI(_TAG, "command %d relay %d state %d\n", sequence, relay, state);
+    return sequence;
+}
+
+/**
+ * Get next command
+ *
+ * @param[out]  command next command
+ * @param[in]   wait    maximum tick to wait
+ *
+ * @return  true if command is received
+ */
+bool RelayCommand::receive(LoadModbus::relay_command_t &command, TickType_t wait)
+{
+    return xQueueReceive(_queue, &command, wait) == pdTRUE;
+}
+
+/**
+ * Update command state, ignored if the command is no longer in history
+ *
+ * @param[in]   sequence    command sequence
+ * @param[in]   state   new state
+ */
+void RelayCommand::setState(uint16_t sequence, LoadModbus::CommandState state)
+{
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    LoadModbus::relay_command_t &command = _history[sequence % RC_MAX_HISTORY];
+    if (command.sequence == sequence)
+    {
+        command.state = state;
+    }
+    xSemaphoreGive(_mutex);
+}
+
+/**
+ * Get command state
+ *
+ * @param[in]   sequence    command sequence
+ *
+ * @return  command state, CMD_EMPTY if the command is no longer in history
+ */
+LoadModbus::CommandState RelayCommand::getState(uint16_t sequence)
+{
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    const LoadModbus::relay_command_t &command = _history[sequence % RC_MAX_HISTORY];
+    LoadModbus::CommandState state = command.sequence == sequence ? command.state : LoadModbus::CMD_EMPTY;
+    xSemaphoreGive(_mutex);
+    return state;
+}
+
+/**
+ * Get last command sequence
+ *
+ * @return  last command sequence, 0 if no command is issued
+ */
+uint16_t RelayCommand::getSequence()
+{
+    return _sequence;
+}
+
+/**
+ * Copy status register
+ *
+ * @brief   register layout
+ *          0 : last command sequence
+ *          1 + 2 * n : sequence of command slot n, slot is sequence % RC_MAX_HISTORY
+ *          2 + 2 * n : relay index (high byte) and state (low byte) of command slot n
+ *
+ * @param[in]   index   first register
+ * @param[in]   count   number of register
+ * @param[out]  buff    register value
+ *
+ * @return  true if success
+ */
+bool RelayCommand::readRegister(uint16_t index, uint16_t count, uint16_t *buff)
+{
+    if ((uint32_t)index + count > RC_REGISTER_SIZE)
+    {
+        return false;
+    }
+
+    uint16_t regs[RC_REGISTER_SIZE];
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    regs[0] = _sequence;
+    for (size_t i = 0; i < RC_MAX_HISTORY; i++)
+    {
+        regs[1 + i * 2] = _history[i].sequence;
+        regs[2 + i * 2] = (_history[i].relay << 8) | _history[i].state;
+    }
+    xSemaphoreGive(_mutex);
+    memcpy(buff, regs + index, count * sizeof(uint16_t));
+    return true;
+}
+
+RelayCommand::~RelayCommand()
+{
+}
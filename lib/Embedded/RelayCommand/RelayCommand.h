@@ -0,0 +1,63 @@
+#ifndef RELAY_COMMAND_H
+#define RELAY_COMMAND_H
+
+#include <Arduino.h>
+#include <array>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+
+#define RC_MAX_HISTORY 8 //number of last command kept for status register
+#define RC_QUEUE_SIZE 8 //maximum pending command
+#define RC_REGISTER_SIZE (1 + RC_MAX_HISTORY * 2) //status register block size
+
+namespace LoadModbus {
+    /**
+     * command state
+     */
+    enum CommandState : uint8_t {
+        CMD_EMPTY = 0, //no command in the slot
+        CMD_QUEUED = 1, //waiting for relay task
+        CMD_PULSING = 2, //pulse is running
+        CMD_CONFIRMED = 3, //feedback match the command
+        CMD_FAILED = 4 //rejected, queue full or feedback does not match
+    };
+
+    /**
+     * relay command
+     */
+    struct relay_command_t {
+        uint16_t sequence = 0; //command sequence, never 0 for valid command
+        uint8_t relay = 0; //relay index, even is ON and odd is OFF pulse
+        CommandState state = CMD_EMPTY;
+    };
+};
+
+/**
+ * Relay command queue with completion status
+ *
+ * @brief   command is pushed from modbus worker and executed by relay task, the state of the last RC_MAX_HISTORY
+ *          command is kept so the master can wait for completion with single read
+ */
+class RelayCommand
+{
+private:
+    /* data */
+    const char* _TAG = "relay-command";
+    QueueHandle_t _queue = NULL;
+    SemaphoreHandle_t _mutex = NULL;
+    std::array<LoadModbus::relay_command_t, RC_MAX_HISTORY> _history;
+    uint16_t _sequence = 0;
+public:
+    RelayCommand();
+    void begin(); //create queue
+    uint16_t push(uint8_t relay, bool isAccepted = true); //queue command, return its sequence
+    bool receive(LoadModbus::relay_command_t &command, TickType_t wait); //get next command, call from relay task
+    void setState(uint16_t sequence, LoadModbus::CommandState state); //update command state
+    LoadModbus::CommandState getState(uint16_t sequence); //get command state, CMD_EMPTY if it is no longer in history
+    uint16_t getSequence(); //get last command sequence
+    bool readRegister(uint16_t index, uint16_t count, uint16_t *buff); //copy status register
+    ~RelayCommand();
+};
+
+#endif
@@ -0,0 +1,164 @@
+#include "RtuBaud.h"
+
+const std::array<uint32_t, 10> RtuBaud::_baudrate = {9600, 14400, 19200, 28800, 38400, 57600, 115200, 230400, 460800, 921600};
+const std::array<uint8_t, 10> RtuBaud::_functionCode = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x0F, 0x10, 0x17, 0x2B};
+
+RtuBaud::RtuBaud()
+{
+}
+
+/**
+ * Get single character time
+ *
+ * @param[in]   baud    baudrate in bps
+ *
+ * @return  character time in us
+ */
+uint32_t RtuBaud::getCharTime(uint32_t baud)
+{
+    if (baud == 0)
+    {
+        return 0;
+    }
+    return (RTU_BITS_PER_CHAR * 1000000UL + baud - 1) / baud;
+}
+
+/**
+ * Get inter-character timeout (t1.5)
+ *
+ * @param[in]   baud    baudrate in bps
+ *
+ * @return  t1.5 in us
+ */
+uint32_t RtuBaud::getInterCharTimeout(uint32_t baud)
+{
+    return getCharTime(baud) * 3 / 2;
+}
+
+/**
+ * Get inter-frame interval (t3.5)
+ *
+ * @brief   follow the character time for every baudrate instead of the fixed 1750 us above 19200 bps,
+ *          so high baudrate is not slowed down by the gap, limited by RTU_MIN_INTERVAL
+ *
+ * @param[in]   baud    baudrate in bps
+ *
+ * @return  t3.5 in us
+ */
+uint32_t RtuBaud::getInterval(uint32_t baud)
+{
+    uint32_t interval = getCharTime(baud) * 7 / 2;
+    return interval < RTU_MIN_INTERVAL ? RTU_MIN_INTERVAL : interval;
+}
+
+/**
+ * Check if frame look like a RTU frame, server id and function code are checked on top of the crc
+ *
+ * @param[in]   frame   received byte
+ * @param[in]   len frame length including crc
+ *
+ * @return  true if the frame is plausible
+ */
+bool RtuBaud::isValidFrame(const uint8_t *frame, size_t len)
+{
+    if (len < 4 || frame[0] > 247 || !RTUutils::validCRC(frame, len))
+    {
+        return false;
+    }
+    uint8_t functionCode = frame[1] & 0x7F; //exception response keep the function code
+    for (uint8_t code : _functionCode)
+    {
+        if (code == functionCode)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Read incoming byte until t3.5 gap and check the frame
+ *
+ * @brief   available byte is drained then the task sleep for one tick, so garbage received on the wrong baudrate
+ *          never keep the task busy. gap shorter than one tick may merge two frame, a merged frame is accepted when
+ *          it start with a valid frame
+ *
+ * @param[in]   serial  serial port, must be started
+ * @param[in]   baud    baudrate in bps
+ * @param[in]   listenTime  time to wait for valid frame in ms
+ *
+ * @return  true if RTU_DETECT_FRAME consecutive valid frame are received
+ */
+bool RtuBaud::readFrame(HardwareSerial &serial, uint32_t baud, uint32_t listenTime)
+{
+    uint8_t frame[RTU_MAX_FRAME];
+    size_t len = 0;
+    size_t validCount = 0;
+    uint32_t interval = getInterval(baud);
+    unsigned long start = millis();
+    unsigned long lastByte = micros();
+
+    while (millis() - start < listenTime)
+    {
+        while (serial.available())
+        {
+            int b = serial.read();
+            if (len < sizeof(frame))
+            {
+                frame[len++] = b;
+            }
+            else //garbage on wrong baudrate, drop it
+            {
+                len = 0;
+                validCount = 0;
+            }
+            lastByte = micros();
+        }
+        if (len > 0 && micros() - lastByte > interval) //end of frame
+        {
+            bool isValid = false;
+            for (size_t end = len; end >= 4 && !isValid; end--) //whole frame first, then frame merged with the next one
+            {
+                isValid = isValidFrame(frame, end);
+            }
+            validCount = isValid ? validCount + 1 : 0;
+            if (validCount >= RTU_DETECT_FRAME)
+            {
+                return true;
+            }
+            len = 0;
+        }
+        vTaskDelay(1);
+    }
+    return false;
+}
+
+/**
+ * Detect master baudrate, each supported baudrate is tried once
+ *
+ * @param[in]   serial  serial port, must be started with any baudrate
+ * @param[in]   listenTime  time to listen on each baudrate in ms, should be longer than twice the master poll period
+ *
+ * @return  detected baudrate in bps, 0 if no valid frame is received
+ */
+uint32_t RtuBaud::detect(HardwareSerial &serial, uint32_t listenTime)
+{
+    for (uint32_t baud : _baudrate)
+    {
+        serial.updateBaudRate(baud);
+        while (serial.available()) //drop byte received on previous baudrate
+        {
+            serial.read();
+        }
+        if (readFrame(serial, baud, listenTime))
+        {
+            ESP_LOGI(_TAG, "detected baudrate %d\n", baud);
+            return baud;
+        }
+    }
+    return 0;
+}
+
+RtuBaud::~RtuBaud()
+{
+}
@@ -0,0 +1,37 @@
+#ifndef RTU_BAUD_H
+#define RTU_BAUD_H
+
+#include <Arduino.h>
+#include <array>
+#include <RTUutils.h>
+
+#define RTU_BITS_PER_CHAR 11 //start, 8 data, parity or second stop, stop
+#define RTU_MIN_INTERVAL 500 //minimum inter-frame gap in us, guard for uart driver latency at high baudrate
+#define RTU_MAX_FRAME 256 //maximum RTU frame including crc
+#define RTU_DETECT_FRAME 2 //consecutive valid frame required to accept a baudrate
+
+/**
+ * RTU baudrate helper
+ *
+ * @brief   derive t1.5 and t3.5 timing from the baudrate, and detect the master baudrate by listening
+ *          for RTU_DETECT_FRAME consecutive frame with valid crc, server id and function code on every supported baudrate
+ */
+class RtuBaud
+{
+private:
+    /* data */
+    const char* _TAG = "rtu-baud";
+    static const std::array<uint32_t, 10> _baudrate;
+    static const std::array<uint8_t, 10> _functionCode;
+    static bool isValidFrame(const uint8_t *frame, size_t len); //check crc, server id and function code
+    bool readFrame(HardwareSerial &serial, uint32_t baud, uint32_t listenTime); //wait for consecutive valid frame
+public:
+    RtuBaud();
+    static uint32_t getCharTime(uint32_t baud); //get single character time in us
+    static uint32_t getInterCharTimeout(uint32_t baud); //get t1.5 in us
+    static uint32_t getInterval(uint32_t baud); //get t3.5 in us
+    uint32_t detect(HardwareSerial &serial, uint32_t listenTime); //detect master baudrate
+    ~RtuBaud();
+};
+
+#endif
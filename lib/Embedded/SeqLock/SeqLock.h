@@ -0,0 +1,215 @@
+#ifndef SEQ_LOCK_H
+#define SEQ_LOCK_H
+
+#include <Arduino.h>
+#include <atomic>
+
+/**
+ * Double buffered seqlock for single writer, multiple reader
+ *
+ * @brief   writer always write into the back buffer and never wait for reader, reader copy the front buffer
+ *          and retry only when the writer publish twice during the copy. sequence is odd while writing,
+ *          the published buffer index is (sequence / 2) % 2
+ *
+ * @tparam  T   trivially copyable data type
+ */
+template <typename T>
+class SeqLockBuffer
+{
+private:
+    T _buffer[2];
+    std::atomic<uint32_t> _sequence;
+public:
+    SeqLockBuffer();
+    void publish(const T &value); //publish new value, call only from single writer
+    bool tryRead(T &value, uint32_t &generation) const; //read latest value once, return false when it is overwritten during copy
+    uint32_t read(T &value) const; //read latest value, retry until consistent, return generation
+    uint32_t getGeneration() const; //get number of published value
+};
+
+template <typename T>
+SeqLockBuffer<T>::SeqLockBuffer() : _sequence(0)
+{
+    _buffer[0] = T();
+    _buffer[1] = T();
+}
+
+/**
+ * Publish new value into back buffer
+ *
+ * @param[in]   value   value to be published
+ */
+template <typename T>
+void SeqLockBuffer<T>::publish(const T &value)
+{
+    uint32_t seq = _sequence.load(std::memory_order_relaxed);
+    _sequence.store(seq + 1, std::memory_order_relaxed); //mark write in progress
+    std::atomic_thread_fence(std::memory_order_release);
+    _buffer[((seq >> 1) + 1) & 1] = value; //write into back buffer, front buffer is untouched
+    _sequence.store(seq + 2, std::memory_order_release); //swap front and back buffer
+}
+
+/**
+ * Try to read latest published value
+ *
+ * @param[out]  value   copy of latest value
+ * @param[out]  generation  generation of the copied value
+ *
+ * @return  true if the copy is consistent
+ */
+template <typename T>
+bool SeqLockBuffer<T>::tryRead(T &value, uint32_t &generation) const
+{
+    uint32_t start = _sequence.load(std::memory_order_acquire) & ~1UL;
+    generation = start >> 1;
+    value = _buffer[(start >> 1) & 1];
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint32_t end = _sequence.load(std::memory_order_relaxed);
+    return (end - start) < 3; //writer only touch this buffer again when it start the second publish
+}
+
+/**
+ * Read latest published value
+ *
+ * @param[out]  value   copy of latest value
+ *
+ * @return  generation of the value
+ */
+template <typename T>
+uint32_t SeqLockBuffer<T>::read(T &value) const
+{
+    uint32_t generation = 0;
+    while (!tryRead(value, generation))
+    {
+    }
+    return generation;
+}
+
+/**
+ * Get generation
+ *
+ * @return  number of published value
+ */
+template <typename T>
+uint32_t SeqLockBuffer<T>::getGeneration() const
+{
+    return _sequence.load(std::memory_order_acquire) >> 1;
+}
+
+/**
+ * Sample frame carried by SampleMailbox
+ *
+ * @tparam  T   trivially copyable sample type
+ */
+template <typename T>
+struct sample_frame_t {
+    T value = T(); //sample
+    uint32_t timestamp = 0; //capture time in us
+    uint32_t sequence = 0; //post sequence, wrap from UINT32_MAX into 1 so 0 always mean nothing is posted
+};
+
+/**
+ * Timestamped sample exchange between acquisition task and control loop
+ *
+ * @brief   single writer post sample with its capture time, reader get the latest sample with its sequence and
+ *          check its age to detect stalled acquisition. neither side ever block, built on SeqLockBuffer.
+ *          the sequence is carried inside the frame instead of the buffer generation, so it never wrap into 0
+ *
+ * @tparam  T   trivially copyable sample type
+ */
+template <typename T>
+class SampleMailbox
+{
+private:
+    SeqLockBuffer<sample_frame_t<T>> _frame;
+    uint32_t _sequence = 0; //sequence of the last post, writer only
+public:
+    SampleMailbox() {}
+    explicit SampleMailbox(uint32_t sequence) : _sequence(sequence) {} //start after sequence, e.g. to resume or test the wrap
+    void post(const T &value); //post sample captured now
+    void post(const T &value, uint32_t timestamp); //post sample with capture time in us
+    uint32_t read(T &value) const; //read latest sample, return sequence, 0 if nothing is posted
+    uint32_t read(T &value, uint32_t &timestamp) const; //read latest sample and its capture time
+    bool isStale(uint32_t maxAge) const; //check if nothing is posted within maxAge us
+};
+
+/**
+ * Post sample captured now
+ *
+ * @param[in]   value   sample
+ */
+template <typename T>
+void SampleMailbox<T>::post(const T &value)
+{
+    post(value, micros());
+}
+
+/**
+ * Post sample with its capture time
+ *
+ * @param[in]   value   sample
+ * @param[in]   timestamp   capture time in us
+ */
+template <typename T>
+void SampleMailbox<T>::post(const T &value, uint32_t timestamp)
+{
+    _sequence = _sequence == UINT32_MAX ? 1 : _sequence + 1;
+    sample_frame_t<T> frame;
+    frame.value = value;
+    frame.timestamp = timestamp;
+    frame.sequence = _sequence;
+    _frame.publish(frame);
+}
+
+/**
+ * Read latest sample
+ *
+ * @param[out]  value   latest sample
+ *
+ * @return  sequence of the sample, 0 if nothing is posted
+ */
+template <typename T>
+uint32_t SampleMailbox<T>::read(T &value) const
+{
+    uint32_t timestamp = 0;
+    return read(value, timestamp);
+}
+
+/**
+ * Read latest sample and its capture time
+ *
+ * @param[out]  value   latest sample
+ * @param[out]  timestamp   capture time in us
+ *
+ * @return  sequence of the sample, 0 if nothing is posted
+ */
+template <typename T>
+uint32_t SampleMailbox<T>::read(T &value, uint32_t &timestamp) const
+{
+    sample_frame_t<T> frame;
+    _frame.read(frame);
+    value = frame.value;
+    timestamp = frame.timestamp;
+    return frame.sequence;
+}
+
+/**
+ * Check if the acquisition is stalled
+ *
+ * @param[in]   maxAge  maximum age of the latest sample in us
+ *
+ * @return  true if nothing is posted or the latest sample is older than maxAge
+ */
+template <typename T>
+bool SampleMailbox<T>::isStale(uint32_t maxAge) const
+{
+    sample_frame_t<T> frame;
+    _frame.read(frame);
+    if (frame.sequence == 0)
+    {
+        return true;
+    }
+    return (uint32_t)(micros() - frame.timestamp) > maxAge;
+}
+
+#endif
@@ -0,0 +1,243 @@
+#include "Talis5Cache.h"
+
+Talis5Cache::Talis5Cache()
+{
+    _mutex = xSemaphoreCreateMutex();
+}
+
+/**
+ * Add ttl rule
+ *
+ * @param[in]   functionCode    READ_HOLD_REGISTER or READ_INPUT_REGISTER
+ * @param[in]   address start address
+ * @param[in]   count   number of register
+ * @param[in]   ttl time to live in ms
+ *
+ * @return  true if success
+ */
+bool Talis5Cache::addRule(uint8_t functionCode, uint16_t address, uint16_t count, uint32_t ttl)
+{
+    if (_ruleSize >= _rule.size() || (functionCode != READ_HOLD_REGISTER && functionCode != READ_INPUT_REGISTER) || count == 0 || ttl == 0)
+    {
+        return false;
+    }
+    _rule[_ruleSize].functionCode = functionCode;
+    _rule[_ruleSize].address = address;
+    _rule[_ruleSize].count = count;
+    _rule[_ruleSize].ttl = ttl;
+    _ruleSize++;
+    return true;
+}
+
+/**
+ * Get ttl of read range, the shortest ttl is used when the range match several rule
+ *
+ * @param[in]   functionCode    function code
+ * @param[in]   address start address
+ * @param[in]   count   number of register
+ *
+ * @return  ttl in ms, 0 if the range is not cached
+ */
+uint32_t Talis5Cache::getTtl(uint8_t functionCode, uint16_t address, uint16_t count)
+{
+    uint32_t ttl = 0;
+    for (size_t i = 0; i < _ruleSize; i++)
+    {
+        const Talis5::cache_rule_t &rule = _rule[i];
+        if (rule.functionCode == functionCode && address >= rule.address && 
+            (uint32_t)address + count <= (uint32_t)rule.address + rule.count)
+        {
+            ttl = ttl == 0 || rule.ttl < ttl ? rule.ttl : ttl;
+        }
+    }
+    return ttl;
+}
+
+/**
+ * Get cached response
+ *
+ * @param[in]   request request message
+ * @param[out]  response    cached response
+ *
+ * @return  true if cached response is valid
+ */
+bool Talis5Cache::lookup(const ModbusMessage &request, ModbusMessage &response)
+{
+    uint16_t address = 0;
+    uint16_t count = 0;
+    uint8_t functionCode = request.getFunctionCode();
+    request.get(2, address, count);
+    if (getTtl(functionCode, address, count) == 0)
+    {
+        return false;
+    }
+
+    bool isHit = false;
+    unsigned long now = millis();
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    for (Talis5::cache_entry_t &entry : _entry)
+    {
+        if (entry.isValid && entry.unit == request.getServerID() && entry.functionCode == functionCode && 
+            entry.address == address && entry.count == count)
+        {
+            if ((long)(now - entry.expire) < 0)
+            {
+                response.add(entry.data.data(), entry.size);
+                isHit = true;
+            }
+            else
+            {
+                entry.isValid = false;
+            }
+            break;
+        }
+    }
+    isHit ? _hit++ : _miss++;
+    xSemaphoreGive(_mutex);
+    return isHit;
+}
+
+/**
+ * Cache response of read request, the oldest entry is replaced when the cache is full
+ *
+ * @param[in]   request request message
+ * @param[in]   response    response from slave
+ */
+void Talis5Cache::store(const ModbusMessage &request, const ModbusMessage &response)
+{
+    uint16_t address = 0;
+    uint16_t count = 0;
+    uint8_t functionCode = request.getFunctionCode();
+    request.get(2, address, count);
+    uint32_t ttl = getTtl(functionCode, address, count);
+    if (ttl == 0 || response.getError() != SUCCESS || response.size() > T5C_MAX_DATA)
+    {
+        return;
+    }
+
+    unsigned long now = millis();
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    Talis5::cache_entry_t *slot = &_entry[0];
+    for (Talis5::cache_entry_t &entry : _entry)
+    {
+        if (entry.isValid && entry.unit == request.getServerID() && entry.functionCode == functionCode && 
+            entry.address == address && entry.count == count) //refresh existing entry
+        {
+            slot = &entry;
+            break;
+        }
+        if (!entry.isValid)
+        {
+            slot = &entry;
+        }
+        else if (slot->isValid && (long)(entry.expire - slot->expire) < 0)
+        {
+            slot = &entry;
+        }
+    }
+    slot->isValid = true;
+    slot->unit = request.getServerID();
+    slot->functionCode = functionCode;
+    slot->address = address;
+    slot->count = count;
+    slot->expire = now + ttl;
+    slot->size = response.size();
+    memcpy(slot->data.data(), response.data(), response.size());
+    xSemaphoreGive(_mutex);
+}
+
+/**
+ * Invalidate cached holding register overlapped by write request (FC06, FC10 and FC17) and every cached input
+ * register of the unit, since holding register such as group command or calibration change the telemetry.
+ * coil write (FC05 and FC0F) invalidate every entry of the unit because its effect on register is not known
+ *
+ * @param[in]   request write request, other request is ignored
+ */
+void Talis5Cache::invalidate(const ModbusMessage &request)
+{
+    uint16_t address = 0;
+    uint16_t count = 1;
+    switch (request.getFunctionCode())
+    {
+    case WRITE_COIL:
+    case WRITE_MULT_COILS:
+        invalidateUnit(request.getServerID());
+        return;
+    case WRITE_HOLD_REGISTER:
+        request.get(2, address);
+        break;
+    case WRITE_MULT_REGISTERS:
+        request.get(2, address, count);
+        break;
+    case R_W_MULT_REGISTERS:
+        request.get(6, address, count);
+        break;
+    default:
+        return;
+    }
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    for (Talis5::cache_entry_t &entry : _entry)
+    {
+        if (entry.isValid && entry.unit == request.getServerID() && (entry.functionCode == READ_INPUT_REGISTER || 
+            (address < (uint32_t)entry.address + entry.count && entry.address < (uint32_t)address + count)))
+        {
+            entry.isValid = false;
+            _invalidate++;
+        }
+    }
+    xSemaphoreGive(_mutex);
+}
+
+/**
+ * Invalidate every cached entry of unit
+ *
+ * @param[in]   unit    unit id
+ */
+void Talis5Cache::invalidateUnit(uint8_t unit)
+{
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    for (Talis5::cache_entry_t &entry : _entry)
+    {
+        if (entry.isValid && entry.unit == unit)
+        {
+            entry.isValid = false;
+            _invalidate++;
+        }
+    }
+    xSemaphoreGive(_mutex);
+}
+
+/**
+ * Get number of request served from cache
+ *
+ * @return  hit counter
+ */
+uint32_t Talis5Cache::getHit()
+{
+    return _hit;
+}
+
+/**
+ * Get number of cacheable request forwarded to the bus
+ *
+ * @return  miss counter
+ */
+uint32_t Talis5Cache::getMiss()
+{
+    return _miss;
+}
+
+/**
+ * Get number of entry invalidated by write request
+ *
+ * @return  invalidate counter
+ */
+uint32_t Talis5Cache::getInvalidate()
+{
+    return _invalidate;
+}
+
+Talis5Cache::~Talis5Cache()
+{
+}
@@ -0,0 +1,73 @@
+#ifndef TALIS5_CACHE_H
+#define TALIS5_CACHE_H
+
+#include <Arduino.h>
+#include <array>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <ModbusMessage.h>
+
+#define T5C_MAX_ENTRY 32 //maximum cached response
+#define T5C_MAX_RULE 16 //maximum ttl rule
+#define T5C_MAX_DATA 256 //maximum response size
+
+namespace Talis5 {
+    /**
+     * ttl rule, read request fully inside the range is cached for ttl ms on every unit
+     */
+    struct cache_rule_t {
+        uint8_t functionCode = 0; //READ_HOLD_REGISTER or READ_INPUT_REGISTER
+        uint16_t address = 0; //start address
+        uint16_t count = 0; //number of register
+        uint32_t ttl = 0; //time to live in ms
+    };
+
+    /**
+     * cached response keyed by unit, function code, address and count
+     */
+    struct cache_entry_t {
+        bool isValid = false;
+        uint8_t unit = 0;
+        uint8_t functionCode = 0;
+        uint16_t address = 0;
+        uint16_t count = 0;
+        unsigned long expire = 0; //time when the entry expire
+        uint16_t size = 0; //response size
+        std::array<uint8_t, T5C_MAX_DATA> data; //response without MBAP header
+    };
+};
+
+/**
+ * Gateway response cache
+ *
+ * @brief   identical FC03 and FC04 request inside the ttl of its rule is answered from memory,
+ *          write into overlapping holding register invalidate the cached holding and every cached input register
+ *          response of that unit, coil write invalidate every cached response of that unit
+ */
+class Talis5Cache
+{
+private:
+    /* data */
+    const char* _TAG = "talis5-cache";
+    std::array<Talis5::cache_rule_t, T5C_MAX_RULE> _rule;
+    size_t _ruleSize = 0;
+    std::array<Talis5::cache_entry_t, T5C_MAX_ENTRY> _entry;
+    SemaphoreHandle_t _mutex = NULL;
+    uint32_t _hit = 0;
+    uint32_t _miss = 0;
+    uint32_t _invalidate = 0;
+    uint32_t getTtl(uint8_t functionCode, uint16_t address, uint16_t count); //get ttl of read range, 0 if not cached
+public:
+    Talis5Cache();
+    bool addRule(uint8_t functionCode, uint16_t address, uint16_t count, uint32_t ttl); //add ttl rule
+    bool lookup(const ModbusMessage &request, ModbusMessage &response); //get cached response
+    void store(const ModbusMessage &request, const ModbusMessage &response); //cache response of read request
+    void invalidate(const ModbusMessage &request); //invalidate entry overlapped by write request
+    void invalidateUnit(uint8_t unit); //invalidate every entry of unit
+    uint32_t getHit(); //get number of request served from cache
+    uint32_t getMiss(); //get number of cacheable request forwarded to the bus
+    uint32_t getInvalidate(); //get number of invalidated entry
+    ~Talis5Cache();
+};
+
+#endif
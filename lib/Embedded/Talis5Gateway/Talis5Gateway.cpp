@@ -0,0 +1,163 @@
+#include "Talis5Gateway.h"
+
+Talis5Gateway::Talis5Gateway(ModbusClientRTU &client) : _client(client)
+{
+}
+
+/**
+ * Start ethernet and gateway server, every slave in the stored slave list is reachable through the gateway
+ *
+ * @param[in]   ethernetSave    stored network setting, must be started with begin
+ * @param[in]   memory  Talis5 memory, must be started with begin
+ * @param[in]   config  gateway config, refer to gateway_config_t
+ *
+ * @return  true if gateway is started
+ */
+bool Talis5Gateway::begin(EthernetSave &ethernetSave, Talis5Memory &memory, const Talis5::gateway_config_t &config)
+{
+    size_t len = memory.getSlaveSize();
+    std::vector<uint8_t> slaveList(len);
+    if (len == 0 || memory.getSlave(slaveList.data(), len) == 0)
+    {
+        ESP_LOGE(_TAG, "slave list is empty\n");
+        return false;
+    }
+
+    if (!LoadModbusTcp::beginEthernet(ethernetSave, config.tcp))
+    {
+        return false;
+    }
+
+    _mutex = xSemaphoreCreateMutex();
+    _queueDepth = config.queueDepth;
+    for (uint8_t id : slaveList)
+    {
+        if (id == 0 || id > 247)
+        {
+            continue;
+        }
+        _server.registerWorker(id, ANY_FUNCTION_CODE, [this](const ModbusMessage &request) { return forward(request); });
+    }
+
+    uint16_t port = memory.getModbusPort() ? memory.getModbusPort() : config.tcp.port;
+    bool isStarted = _server.start(port, config.tcp.maxClient, config.tcp.idleTimeout, config.tcp.coreId);
+    ESP_LOGI(_TAG, "gateway on %s:%d, %d slave, started = %d\n", Ethernet.localIP().toString().c_str(), port, slaveList.size(), isStarted);
+    return isStarted;
+}
+
+/**
+ * Reserve slot in RTU queue
+ *
+ * @return  true if the queue is not saturated
+ */
+bool Talis5Gateway::acquire()
+{
+    bool isAcquired = false;
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    if (_pending < _queueDepth)
+    {
+        _pending++;
+        isAcquired = true;
+    }
+    else
+    {
+        _busyCount++;
+    }
+    xSemaphoreGive(_mutex);
+    return isAcquired;
+}
+
+/**
+ * Release slot in RTU queue
+ */
+void Talis5Gateway::release()
+{
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    _pending--;
+    _forwardCount++;
+    xSemaphoreGive(_mutex);
+}
+
+/**
+ * Forward request into RTU bus and wait for the response
+ *
+ * @param[in]   request request from tcp client without MBAP header
+ *
+ * @return  response from slave, SERVER_DEVICE_BUSY when the queue is saturated
+ *          or the error mapped by Talis5Policy::toGatewayError
+ */
+ModbusMessage Talis5Gateway::forward(const ModbusMessage &request)
+{
+    ModbusMessage response;
+    if (_cache.lookup(request, response))
+    {
+        return response;
+    }
+
+    if (!acquire())
+    {
+        response.setError(request.getServerID(), request.getFunctionCode(), SERVER_DEVICE_BUSY);
+        return response;
+    }
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    uint32_t token = _token++;
+    xSemaphoreGive(_mutex);
+    response = _client.syncRequest(request, token);
+    release();
+
+    _cache.invalidate(request); //write may be applied even when its reply is lost
+    Error err = Talis5Policy::toGatewayError(response.getError());
+    if (err != response.getError()) //timeout, crc and other error detected by the client
+    {
+        ESP_LOGD(_TAG, "slave %d error %02X\n", request.getServerID(), response.getError());
+        response.setError(request.getServerID(), request.getFunctionCode(), err);
+        return response;
+    }
+    _cache.store(request, response);
+    return response;
+}
+
+/**
+ * Get number of connected client
+ *
+ * @return  number of active client
+ */
+uint16_t Talis5Gateway::getActiveClient()
+{
+    return _server.activeClients();
+}
+
+/**
+ * Get number of forwarded transaction
+ *
+ * @return  forwarded transaction
+ */
+uint32_t Talis5Gateway::getForwardCount()
+{
+    return _forwardCount;
+}
+
+/**
+ * Get number of transaction rejected with server busy
+ *
+ * @return  rejected transaction
+ */
+uint32_t Talis5Gateway::getBusyCount()
+{
+    return _busyCount;
+}
+
+/**
+ * Get response cache
+ *
+ * @return  response cache
+ */
+Talis5Cache& Talis5Gateway::getCache()
+{
+    return _cache;
+}
+
+Talis5Gateway::~Talis5Gateway()
+{
+}
@@ -0,0 +1,59 @@
+#ifndef TALIS5_GATEWAY_H
+#define TALIS5_GATEWAY_H
+
+#include <Arduino.h>
+#include <vector>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <ModbusClientRTU.h>
+#include <LoadModbusTcp.h>
+#include <Talis5Memory.h>
+#include <Talis5Cache.h>
+#include <Talis5Policy.h>
+
+namespace Talis5 {
+    /**
+     * config struct for TCP to RTU gateway
+     */
+    struct gateway_config_t {
+        LoadModbus::modbus_tcp_config_t tcp; //W5x00 pin and tcp server config, port is taken from Talis5Memory when it is set
+        uint8_t queueDepth = 8; //maximum transaction waiting for the RS485 bus, exception 0x06 is returned above it
+    };
+};
+
+/**
+ * Modbus TCP to RTU gateway
+ *
+ * @brief   every tcp client is served by its own task and each transaction is forwarded into the RTU client queue,
+ *          so the bus serve the transaction in arrival order and one pending transaction per client keep client fair.
+ *          pipelined request from a client wait in its socket and the response is sent with the matching transaction id.
+ *          repeated read is answered from the response cache when it match a ttl rule
+ */
+class Talis5Gateway
+{
+private:
+    /* data */
+    const char* _TAG = "talis5-gateway";
+    ModbusClientRTU &_client;
+    ModbusServerEthernet _server;
+    Talis5Cache _cache;
+    SemaphoreHandle_t _mutex = NULL;
+    uint8_t _queueDepth = 0;
+    uint8_t _pending = 0;
+    uint32_t _token = 0;
+    uint32_t _forwardCount = 0;
+    uint32_t _busyCount = 0;
+    bool acquire(); //reserve slot in RTU queue
+    void release(); //release slot in RTU queue
+    ModbusMessage forward(const ModbusMessage &request); //forward request into RTU bus
+public:
+    Talis5Gateway(ModbusClientRTU &client);
+    bool begin(EthernetSave &ethernetSave, Talis5Memory &memory, const Talis5::gateway_config_t &config); //start ethernet and gateway server
+    uint16_t getActiveClient(); //get number of connected client
+    uint32_t getForwardCount(); //get number of forwarded transaction
+    uint32_t getBusyCount(); //get number of transaction rejected with server busy
+    Talis5Cache& getCache(); //get response cache to add ttl rule and read counter
+    ~Talis5Gateway();
+};
+
+#endif
@@ -0,0 +1,136 @@
+#include "Talis5Policy.h"
+
+/**
+ * Merge range into batch, contiguous or overlapping range with the same function code is read in single
+ * request as long as the request does not exceed T5P_MAX_REGISTER. range separated by a gap is never merged,
+ * the load controller rejects any read that touches an unmapped register
+ *
+ * @param[in]   range   register range in any order
+ * @param[out]  batch   merged request sorted by function code and address, offset is assigned in cache order
+ *
+ * @return  number of cached register for single slave
+ */
+uint16_t Talis5Policy::mergeRange(const std::vector<Talis5::poll_range_t> &range, std::vector<Talis5::poll_range_t> &batch)
+{
+    std::vector<Talis5::poll_range_t> sorted = range;
+    std::sort(sorted.begin(), sorted.end(), [](const Talis5::poll_range_t &a, const Talis5::poll_range_t &b) {
+        return a.functionCode != b.functionCode ? a.functionCode < b.functionCode : a.address < b.address;
+    });
+
+    batch.clear();
+    uint16_t cacheSize = 0;
+    for (const Talis5::poll_range_t &r : sorted)
+    {
+        if (!batch.empty())
+        {
+            Talis5::poll_range_t &last = batch.back();
+            uint32_t lastEnd = (uint32_t)last.address + last.count;
+            uint32_t end = (uint32_t)r.address + r.count;
+            if (last.functionCode == r.functionCode && r.address <= lastEnd && 
+                (end > lastEnd ? end : lastEnd) - last.address <= T5P_MAX_REGISTER)
+            {
+                if (end > lastEnd)
+                {
+                    cacheSize += end - lastEnd;
+                    last.count = end - last.address;
+                }
+                continue;
+            }
+        }
+        Talis5::poll_range_t merged = r;
+        merged.offset = cacheSize;
+        cacheSize += merged.count;
+        batch.push_back(merged);
+    }
+    return cacheSize;
+}
+
+/**
+ * Update response time and adaptive timeout after successful request
+ *
+ * @param[in]   slave   slave state
+ * @param[in]   time    response time in ms
+ *
+ * @return  true if the slave was offline
+ */
+bool Talis5Policy::recordSuccess(Talis5::slave_state_t &slave, uint32_t time)
+{
+    bool isRecovered = !slave.isOnline;
+    slave.success++;
+    slave.failCount = 0;
+    slave.backoff = 0;
+    slave.isOnline = true;
+    slave.averageTime = slave.success == 1 ? time : (slave.averageTime * 7 + time) / 8;
+    uint32_t timeout = slave.averageTime * 3 + T5P_TIMEOUT_MARGIN;
+    slave.timeout = timeout < T5P_MIN_TIMEOUT ? T5P_MIN_TIMEOUT : (timeout > T5P_MAX_TIMEOUT ? T5P_MAX_TIMEOUT : timeout);
+    return isRecovered;
+}
+
+/**
+ * Update failure counter, mark slave offline and apply backoff. only a missing or corrupt response
+ * (timeout, crc, length and id mismatch) count against liveness, an exception reply proves that the
+ * slave is alive and keeps it online
+ *
+ * @param[in]   slave   slave state
+ * @param[in]   err error of the request
+ * @param[in]   now current time in ms
+ *
+ * @return  true if the slave was online
+ */
+bool Talis5Policy::recordFailure(Talis5::slave_state_t &slave, Error err, unsigned long now)
+{
+    slave.error++;
+    if (!isNoResponse(err))
+    {
+        if (err < TIMEOUT) //exception reply
+        {
+            slave.failCount = 0;
+            slave.backoff = 0;
+            slave.isOnline = true;
+        }
+        return false;
+    }
+    slave.failCount++;
+    if (err == TIMEOUT) //slower than expected, widen the timeout
+    {
+        slave.timeout = slave.timeout * 2 > T5P_MAX_TIMEOUT ? T5P_MAX_TIMEOUT : slave.timeout * 2;
+    }
+    if (slave.failCount < T5P_DEAD_COUNT)
+    {
+        return false;
+    }
+    bool isLost = slave.isOnline;
+    slave.isOnline = false;
+    slave.backoff = slave.backoff == 0 ? T5P_MIN_BACKOFF : (slave.backoff * 2 > T5P_MAX_BACKOFF ? T5P_MAX_BACKOFF : slave.backoff * 2);
+    slave.skipUntil = now + slave.backoff;
+    return isLost;
+}
+
+/**
+ * Check if the slave did not answer the request
+ *
+ * @param[in]   err error of the response from the RTU client
+ *
+ * @return  true for timeout, crc and other client error, false for success, slave exception and full request queue
+ */
+bool Talis5Policy::isNoResponse(Error err)
+{
+    return err >= TIMEOUT && err != REQUEST_QUEUE_FULL;
+}
+
+/**
+ * Map error of forwarded request into the error returned to tcp client
+ *
+ * @param[in]   err error of the response from the RTU client
+ *
+ * @return  err for success and slave exception, SERVER_DEVICE_BUSY when the RTU client queue is full
+ *          or GATEWAY_TARGET_NO_RESP when the slave does not respond correctly (timeout, crc and other client error)
+ */
+Error Talis5Policy::toGatewayError(Error err)
+{
+    if (err == REQUEST_QUEUE_FULL)
+    {
+        return SERVER_DEVICE_BUSY;
+    }
+    return isNoResponse(err) ? GATEWAY_TARGET_NO_RESP : err;
+}
@@ -0,0 +1,61 @@
+#ifndef TALIS5_POLICY_H
+#define TALIS5_POLICY_H
+
+#include <Arduino.h>
+#include <vector>
+#include <algorithm>
+#include <ModbusTypeDefs.h>
+
+#define T5P_MAX_REGISTER 125 //maximum register for single read request
+#define T5P_MIN_TIMEOUT 50 //minimum adaptive response timeout in ms
+#define T5P_MAX_TIMEOUT 1000 //maximum adaptive response timeout in ms, also used before the first response
+#define T5P_TIMEOUT_MARGIN 20 //margin added to average response time in ms
+#define T5P_DEAD_COUNT 3 //consecutive request without response before slave is marked offline
+#define T5P_MIN_BACKOFF 1000 //first backoff of offline slave in ms
+#define T5P_MAX_BACKOFF 60000 //maximum backoff of offline slave in ms
+
+namespace Talis5 {
+    /**
+     * polled register range, cache offset is assigned by begin
+     */
+    struct poll_range_t {
+        uint8_t functionCode = 0; //READ_HOLD_REGISTER or READ_INPUT_REGISTER
+        uint16_t address = 0; //start address
+        uint16_t count = 0; //number of register
+        uint16_t offset = 0; //offset in slave cache
+    };
+
+    /**
+     * state of single slave
+     */
+    struct slave_state_t {
+        uint8_t id = 0; //slave id
+        bool isOnline = true; //false after T5P_DEAD_COUNT consecutive request without response
+        uint8_t failCount = 0; //consecutive request without response
+        uint32_t averageTime = 0; //average response time in ms
+        uint32_t timeout = T5P_MAX_TIMEOUT; //adaptive response timeout in ms
+        uint32_t backoff = 0; //current backoff in ms
+        unsigned long skipUntil = 0; //offline slave is skipped until this time
+        unsigned long lastUpdate = 0; //time of last complete poll
+        uint32_t success = 0; //number of successful request
+        uint32_t error = 0; //number of failed request
+    };
+};
+
+/**
+ * RTU bus policy of the Talis5 poller and gateway
+ *
+ * @brief   range merging, adaptive timeout, offline backoff and gateway error mapping without the RTU client,
+ *          so it is built and tested on the host. caller keep its own locking
+ */
+class Talis5Policy
+{
+public:
+    static uint16_t mergeRange(const std::vector<Talis5::poll_range_t> &range, std::vector<Talis5::poll_range_t> &batch); //merge range into batch, return cache size of single slave
+    static bool recordSuccess(Talis5::slave_state_t &slave, uint32_t time); //update adaptive timeout, return true if slave is back online
+    static bool recordFailure(Talis5::slave_state_t &slave, Error err, unsigned long now); //update failure and backoff, return true if slave goes offline
+    static bool isNoResponse(Error err); //true if the slave did not answer, false for exception reply
+    static Error toGatewayError(Error err); //map error of forwarded request into the error returned to tcp client
+};
+
+#endif
@@ -0,0 +1,270 @@
+#include "Talis5Poller.h"
+
+Talis5Poller::Talis5Poller(ModbusClientRTU &client) : _client(client)
+{
+}
+
+/**
+ * Add register range polled from every slave
+ *
+ * @param[in]   functionCode    READ_HOLD_REGISTER or READ_INPUT_REGISTER
+ * @param[in]   address start address
+ * @param[in]   count   number of register
+ *
+ * @return  true if success
+ */
+bool Talis5Poller::addRange(uint8_t functionCode, uint16_t address, uint16_t count)
+{
+    if ((functionCode != READ_HOLD_REGISTER && functionCode != READ_INPUT_REGISTER) || count == 0 || count > T5P_MAX_REGISTER)
+    {
+        return false;
+    }
+    Talis5::poll_range_t range;
+    range.functionCode = functionCode;
+    range.address = address;
+    range.count = count;
+    _request.push_back(range);
+    return true;
+}
+
+/**
+ * Load slave list and start polling task
+ *
+ * @param[in]   memory  Talis5 memory, must be started with begin
+ *
+ * @return  true if polling is started
+ */
+bool Talis5Poller::begin(Talis5Memory &memory)
+{
+    size_t len = memory.getSlaveSize();
+    std::vector<uint8_t> slaveList(len);
+    if (len == 0 || memory.getSlave(slaveList.data(), len) == 0 || _request.empty())
+    {
+        ESP_LOGE(_TAG, "no slave or register range to poll\n");
+        return false;
+    }
+
+    _cacheSize = Talis5Policy::mergeRange(_request, _batch);
+    _slave.clear();
+    for (uint8_t id : slaveList)
+    {
+        if (id == 0 || id > 247) //broadcast and reserved id is never polled
+        {
+            continue;
+        }
+        Talis5::slave_state_t slave;
+        slave.id = id;
+        _slave.push_back(slave);
+    }
+    _cache.assign(_slave.size() * _cacheSize, 0);
+    _mutex = xSemaphoreCreateMutex();
+    _rateStart = millis();
+
+    ESP_LOGI(_TAG, "poll %d slave, %d request each, cache %d register each\n", _slave.size(), _batch.size(), _cacheSize);
+    xTaskCreate(&Talis5Poller::pollTask, "talis5 poll task", 4096, this, 2, NULL);
+    return true;
+}
+
+/**
+ * Update response time and adaptive timeout after successful request
+ *
+ * @param[in]   slave   slave state
+ * @param[in]   time    response time in ms
+ */
+void Talis5Poller::recordSuccess(Talis5::slave_state_t &slave, uint32_t time)
+{
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    if (Talis5Policy::recordSuccess(slave, time))
+    {
+        ESP_LOGI(_TAG, "slave %d is online\n", slave.id);
+    }
+    xSemaphoreGive(_mutex);
+}
+
+/**
+ * Update failure counter, mark slave offline and apply backoff
+ *
+ * @param[in]   slave   slave state
+ * @param[in]   err error of the request
+ */
+void Talis5Poller::recordFailure(Talis5::slave_state_t &slave, Error err)
+{
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    if (Talis5Policy::recordFailure(slave, err, millis()))
+    {
+        ESP_LOGW(_TAG, "slave %d is offline, error %d\n", slave.id, err);
+    }
+    else if (err < TIMEOUT)
+    {
+        ESP_LOGW(_TAG, "slave %d exception %02X\n", slave.id, err);
+    }
+    xSemaphoreGive(_mutex);
+}
+
+/**
+ * Read single batch from slave into cache
+ *
+ * @param[in]   slaveIndex  index of slave
+ * @param[in]   batch   merged request
+ *
+ * @return  true if success
+ */
+bool Talis5Poller::pollBatch(size_t slaveIndex, const Talis5::poll_range_t &batch)
+{
+    Talis5::slave_state_t &slave = _slave[slaveIndex];
+    _client.setTimeout(slave.timeout);
+    unsigned long start = millis();
+    ModbusMessage response = _client.syncRequest(_token++, slave.id, batch.functionCode, batch.address, batch.count);
+    uint32_t time = millis() - start;
+
+    Error err = response.getError();
+    if (err == SUCCESS && response.size() < 3 + batch.count * 2)
+    {
+        err = PACKET_LENGTH_ERROR;
+    }
+    if (err != SUCCESS)
+    {
+        recordFailure(slave, err);
+        return false;
+    }
+
+    uint16_t *cache = _cache.data() + slaveIndex * _cacheSize + batch.offset;
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    uint16_t index = 3;
+    for (size_t i = 0; i < batch.count; i++)
+    {
+        index = response.get(index, cache[i]);
+    }
+    xSemaphoreGive(_mutex);
+    recordSuccess(slave, time);
+    _pollCount++;
+    return true;
+}
+
+/**
+ * Poll every slave once, offline slave is skipped until its backoff expire and
+ * the remaining request of a slave is skipped on the first failure
+ */
+void Talis5Poller::poll()
+{
+    for (size_t i = 0; i < _slave.size(); i++)
+    {
+        if (!_slave[i].isOnline && (long)(millis() - _slave[i].skipUntil) < 0)
+        {
+            continue;
+        }
+
+        bool isComplete = true;
+        for (const Talis5::poll_range_t &batch : _batch)
+        {
+            if (!pollBatch(i, batch))
+            {
+                isComplete = false;
+                break;
+            }
+        }
+        if (isComplete)
+        {
+            xSemaphoreTake(_mutex, portMAX_DELAY);
+            _slave[i].lastUpdate = millis();
+            xSemaphoreGive(_mutex);
+        }
+
+        unsigned long elapsed = millis() - _rateStart;
+        if (elapsed >= 1000)
+        {
+            _pollRate = _pollCount * 1000 / elapsed;
+            _pollCount = 0;
+            _rateStart = millis();
+            ESP_LOGI(_TAG, "%d poll/s\n", _pollRate);
+        }
+    }
+}
+
+/**
+ * Task to poll every slave
+ *
+ * @param[in]   pvParameter pointer to Talis5Poller object
+ */
+void Talis5Poller::pollTask(void *pvParameter)
+{
+    Talis5Poller *poller = static_cast<Talis5Poller*>(pvParameter);
+    while (1)
+    {
+        poller->poll();
+        delay(1); //give another task time when every slave is offline
+    }
+}
+
+/**
+ * Copy cached register
+ *
+ * @param[in]   id  slave id
+ * @param[in]   functionCode    READ_HOLD_REGISTER or READ_INPUT_REGISTER
+ * @param[in]   address start address
+ * @param[in]   count   number of register
+ * @param[out]  buff    register value
+ *
+ * @return  true if the range is part of the polled register range of the slave
+ */
+bool Talis5Poller::getRegister(uint8_t id, uint8_t functionCode, uint16_t address, uint16_t count, uint16_t *buff)
+{
+    for (size_t i = 0; i < _slave.size(); i++)
+    {
+        if (_slave[i].id != id)
+        {
+            continue;
+        }
+        for (const Talis5::poll_range_t &batch : _batch)
+        {
+            if (batch.functionCode == functionCode && address >= batch.address && 
+                (uint32_t)address + count <= (uint32_t)batch.address + batch.count)
+            {
+                const uint16_t *cache = _cache.data() + i * _cacheSize + batch.offset + (address - batch.address);
+                xSemaphoreTake(_mutex, portMAX_DELAY);
+                memcpy(buff, cache, count * sizeof(uint16_t));
+                xSemaphoreGive(_mutex);
+                return true;
+            }
+        }
+        return false;
+    }
+    return false;
+}
+
+/**
+ * Copy slave state
+ *
+ * @param[in]   id  slave id
+ * @param[out]  state   slave state
+ *
+ * @return  true if slave is in the slave list
+ */
+bool Talis5Poller::getSlaveState(uint8_t id, Talis5::slave_state_t &state)
+{
+    for (const Talis5::slave_state_t &slave : _slave)
+    {
+        if (slave.id == id)
+        {
+            xSemaphoreTake(_mutex, portMAX_DELAY);
+            state = slave;
+            xSemaphoreGive(_mutex);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Get achieved poll rate
+ *
+ * @return  successful request per second, updated every second
+ */
+uint32_t Talis5Poller::getPollRate()
+{
+    return _pollRate;
+}
+
+Talis5Poller::~Talis5Poller()
+{
+}
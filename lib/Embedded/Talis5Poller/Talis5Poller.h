@@ -0,0 +1,50 @@
+#ifndef TALIS5_POLLER_H
+#define TALIS5_POLLER_H
+
+#include <Arduino.h>
+#include <vector>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <ModbusClientRTU.h>
+#include <Talis5Memory.h>
+#include <Talis5Policy.h>
+
+/**
+ * Modbus RTU polling engine for the Talis5 slave list
+ *
+ * @brief   every slave in the stored slave list is polled for the same register range, contiguous range is
+ *          merged into single request. response timeout follow the average response time of each slave and
+ *          offline slave is retried with exponential backoff. the latest value is kept in per slave cache
+ */
+class Talis5Poller
+{
+private:
+    /* data */
+    const char* _TAG = "talis5-poller";
+    ModbusClientRTU &_client;
+    std::vector<Talis5::poll_range_t> _request; //range added by user
+    std::vector<Talis5::poll_range_t> _batch; //merged request
+    std::vector<Talis5::slave_state_t> _slave;
+    std::vector<uint16_t> _cache; //slave major, _cacheSize register for each slave
+    uint16_t _cacheSize = 0;
+    SemaphoreHandle_t _mutex = NULL;
+    uint32_t _pollCount = 0;
+    uint32_t _pollRate = 0;
+    unsigned long _rateStart = 0;
+    uint32_t _token = 0;
+    bool pollBatch(size_t slaveIndex, const Talis5::poll_range_t &batch); //read single batch from slave
+    void recordSuccess(Talis5::slave_state_t &slave, uint32_t time); //update adaptive timeout under lock
+    void recordFailure(Talis5::slave_state_t &slave, Error err); //update failure and backoff under lock
+    static void pollTask(void *pvParameter); //task to poll every slave
+public:
+    Talis5Poller(ModbusClientRTU &client);
+    bool addRange(uint8_t functionCode, uint16_t address, uint16_t count); //add register range, call before begin
+    bool begin(Talis5Memory &memory); //load slave list and start polling task
+    void poll(); //poll every slave once
+    bool getRegister(uint8_t id, uint8_t functionCode, uint16_t address, uint16_t count, uint16_t *buff); //copy cached register
+    bool getSlaveState(uint8_t id, Talis5::slave_state_t &state); //copy slave state
+    uint32_t getPollRate(); //get completed request per second
+    ~Talis5Poller();
+};
+
+#endif
@@ -0,0 +1,256 @@
+#ifndef WINDOW_STATS_H
+#define WINDOW_STATS_H
+
+#include <Arduino.h>
+#include <array>
+
+#define WS_CHANNEL_SIZE 4 //register for each channel : mean, rms, min, max
+
+namespace WindowStat {
+    /**
+     * statistic of single channel over one window, in the channel register unit
+     */
+    struct channel_stat_t {
+        int16_t mean = 0;
+        uint16_t rms = 0;
+        int16_t min = 0;
+        int16_t max = 0;
+    };
+
+    /**
+     * last completed window of every level, published to modbus task
+     *
+     * @tparam  N   number of channel
+     * @tparam  L   number of window level
+     */
+    template <size_t N, size_t L>
+    struct stat_snapshot_t {
+        std::array<uint16_t, L> sequence = {}; //incremented every time the window of the level is completed
+        std::array<std::array<channel_stat_t, N>, L> channel = {};
+
+        static constexpr size_t levelSize = 1 + N * WS_CHANNEL_SIZE; //register for each level
+        static constexpr size_t size = L * levelSize; //register of the whole snapshot
+
+        /**
+         * Copy snapshot register, each level is window sequence followed by mean, rms, min, max of every channel
+         *
+         * @param[in]   index   first register index
+         * @param[in]   count   number of register
+         * @param[out]  buff    register buffer
+         *
+         * @return  false if range is outside the snapshot
+         */
+        bool readRegister(uint16_t index, uint16_t count, uint16_t *buff) const
+        {
+            if (index + count > size)
+            {
+                return false;
+            }
+            for (size_t i = 0; i < count; i++)
+            {
+                size_t level = (index + i) / levelSize;
+                size_t offset = (index + i) % levelSize;
+                if (offset == 0)
+                {
+                    buff[i] = sequence[level];
+                    continue;
+                }
+                const channel_stat_t &stat = channel[level][(offset - 1) / WS_CHANNEL_SIZE];
+                switch ((offset - 1) % WS_CHANNEL_SIZE)
+                {
+                case 0:
+                    buff[i] = stat.mean;
+                    break;
+                case 1:
+                    buff[i] = stat.rms;
+                    break;
+                case 2:
+                    buff[i] = stat.min;
+                    break;
+                default:
+                    buff[i] = stat.max;
+                    break;
+                }
+            }
+            return true;
+        }
+    };
+};
+
+/**
+ * Streaming windowed statistic of several channel
+ *
+ * @brief   every level keep running sum, sum of square, min and max of each channel over a tumbling window, so
+ *          update is O(1) per sample and memory is fixed. when the window time is elapsed the result is moved into
+ *          the snapshot and the accumulator restart. call update from single writer and publish getSnapshot
+ *
+ * @tparam  N   number of channel
+ * @tparam  L   number of window level
+ */
+template <size_t N, size_t L>
+class WindowStats
+{
+private:
+    struct accumulator_t {
+        int64_t sum = 0;
+        uint64_t sumSquare = 0;
+        int16_t min = INT16_MAX;
+        int16_t max = INT16_MIN;
+    };
+    std::array<uint32_t, L> _window = {}; //window length in ms
+    std::array<uint32_t, L> _start = {}; //start time of running window in ms
+    std::array<uint32_t, L> _count = {}; //sample in running window
+    std::array<std::array<accumulator_t, N>, L> _accumulator;
+    WindowStat::stat_snapshot_t<N, L> _snapshot;
+    static uint16_t squareRoot(uint64_t value); //integer square root
+    void close(size_t level); //move running window into snapshot
+public:
+    WindowStats() {}
+    void setWindow(size_t level, uint32_t window, uint32_t now); //set window length in ms and restart the level
+    uint32_t getWindow(size_t level) const; //get window length in ms
+    bool update(const std::array<int16_t, N> &value, const std::array<int16_t, N> &min, const std::array<int16_t, N> &max, uint32_t now); //add sample, return true if any window is completed
+    const WindowStat::stat_snapshot_t<N, L>& getSnapshot() const; //get last completed window of every level
+};
+
+/**
+ * Set window length and restart the level
+ *
+ * @param[in]   level   window level
+ * @param[in]   window  window length in ms, 0 disable the level
+ * @param[in]   now current time in ms
+ */
+template <size_t N, size_t L>
+void WindowStats<N, L>::setWindow(size_t level, uint32_t window, uint32_t now)
+{
+    if (level >= L)
+    {
+        return;
+    }
+    _window[level] = window;
+    _start[level] = now;
+    _count[level] = 0;
+    _accumulator[level].fill(accumulator_t());
+}
+
+/**
+ * Get window length
+ *
+ * @param[in]   level   window level
+ *
+ * @return  window length in ms
+ */
+template <size_t N, size_t L>
+uint32_t WindowStats<N, L>::getWindow(size_t level) const
+{
+    return level < L ? _window[level] : 0;
+}
+
+/**
+ * Add sample of every channel
+ *
+ * @param[in]   value   sample value, used for mean and rms
+ * @param[in]   min minimum seen since previous sample (e.g. block minimum), same as value if not available
+ * @param[in]   max maximum seen since previous sample, same as value if not available
+ * @param[in]   now current time in ms
+ *
+ * @return  true if any window is completed
+ */
+template <size_t N, size_t L>
+bool WindowStats<N, L>::update(const std::array<int16_t, N> &value, const std::array<int16_t, N> &min, const std::array<int16_t, N> &max, uint32_t now)
+{
+    bool isCompleted = false;
+    for (size_t level = 0; level < L; level++)
+    {
+        if (!_window[level])
+        {
+            continue;
+        }
+        if (now - _start[level] >= _window[level])
+        {
+            close(level);
+            _start[level] = now;
+            isCompleted = true;
+        }
+        for (size_t i = 0; i < N; i++)
+        {
+            accumulator_t &acc = _accumulator[level][i];
+            acc.sum += value[i];
+            acc.sumSquare += (int32_t)value[i] * value[i];
+            acc.min = min[i] < acc.min ? min[i] : acc.min;
+            acc.max = max[i] > acc.max ? max[i] : acc.max;
+        }
+        _count[level]++;
+    }
+    return isCompleted;
+}
+
+/**
+ * Move running window into snapshot and restart the accumulator
+ *
+ * @param[in]   level   window level
+ */
+template <size_t N, size_t L>
+void WindowStats<N, L>::close(size_t level)
+{
+    if (_count[level])
+    {
+        for (size_t i = 0; i < N; i++)
+        {
+            const accumulator_t &acc = _accumulator[level][i];
+            WindowStat::channel_stat_t &stat = _snapshot.channel[level][i];
+            stat.mean = acc.sum / (int64_t)_count[level];
+            stat.rms = squareRoot(acc.sumSquare / _count[level]);
+            stat.min = acc.min;
+            stat.max = acc.max;
+        }
+        _snapshot.sequence[level]++;
+    }
+    _count[level] = 0;
+    _accumulator[level].fill(accumulator_t());
+}
+
+/**
+ * Integer square root
+ *
+ * @param[in]   value   value, at most INT16_MIN squared
+ *
+ * @return  floor of square root
+ */
+template <size_t N, size_t L>
+uint16_t WindowStats<N, L>::squareRoot(uint64_t value)
+{
+    uint32_t op = value;
+    uint32_t result = 0;
+    uint32_t one = 1UL << 30;
+    while (one > op)
+    {
+        one >>= 2;
+    }
+    while (one)
+    {
+        if (op >= result + one)
+        {
+            op -= result + one;
+            result = (result >> 1) + one;
+        }
+        else
+        {
+            result >>= 1;
+        }
+        one >>= 2;
+    }
+    return result > UINT16_MAX ? UINT16_MAX : result;
+}
+
+/**
+ * Get last completed window of every level
+ *
+ * @return  statistic snapshot
+ */
+template <size_t N, size_t L>
+const WindowStat::stat_snapshot_t<N, L>& WindowStats<N, L>::getSnapshot() const
+{
+    return _snapshot;
+}
+
+#endif
@@ -0,0 +1,101 @@
+#include "ZeroTracker.h"
+
+ZeroTracker::ZeroTracker()
+{
+}
+
+/**
+ * Start tracking from the config
+ *
+ * @param[in]   config  CC6940 config, midpoint and stored offset
+ */
+void ZeroTracker::begin(const CC6940Config &config)
+{
+    _midPoint = config.midPoint;
+    _estimate = config.offset * ZT_ONE;
+    _isOpen = false;
+}
+
+/**
+ * Add sample
+ *
+ * @param[in]   adcInMillivolts sensor output in mV / 2^fractionBits (e.g. oversampled block mean)
+ * @param[in]   isOpen  true if the channel relay feedback is open
+ * @param[in]   fractionBits    fraction bit of the sample (0 - ZT_FRACTION), 0 for whole mV
+ *
+ * @return  true if the sample move the estimate
+ */
+bool ZeroTracker::update(uint32_t adcInMillivolts, bool isOpen, uint8_t fractionBits)
+{
+    if (!isOpen)
+    {
+        _isOpen = false;
+        return false;
+    }
+    if (!_isOpen)
+    {
+        _isOpen = true;
+        _openSince = millis();
+    }
+    if (millis() - _openSince < ZT_SETTLE_TIME) //load current may still decay after the relay open
+    {
+        return false;
+    }
+
+    if (fractionBits > ZT_FRACTION)
+    {
+        return false;
+    }
+    int32_t sample = (int32_t)((int64_t)adcInMillivolts * (ZT_ONE >> fractionBits) - (int64_t)_midPoint * ZT_ONE);
+    int32_t error = sample - _estimate;
+    if (abs(error) > ZT_OUTLIER * ZT_ONE)
+    {
+        _rejected++;
+        return false;
+    }
+    _estimate += error / (1 << ZT_FILTER_SHIFT); //symmetric rounding toward zero
+    if (_estimate > ZT_MAX_OFFSET * ZT_ONE)
+    {
+        _estimate = ZT_MAX_OFFSET * ZT_ONE;
+    }
+    else if (_estimate < -ZT_MAX_OFFSET * ZT_ONE)
+    {
+        _estimate = -ZT_MAX_OFFSET * ZT_ONE;
+    }
+    _accepted++;
+    return true;
+}
+
+/**
+ * Get learned offset
+ *
+ * @return  offset from midpoint in mV, rounded
+ */
+int32_t ZeroTracker::getOffset() const
+{
+    return (_estimate + (_estimate >= 0 ? ZT_ONE / 2 : -ZT_ONE / 2)) / ZT_ONE;
+}
+
+/**
+ * Get number of accepted sample
+ *
+ * @return  accepted sample counter
+ */
+uint32_t ZeroTracker::getAccepted() const
+{
+    return _accepted;
+}
+
+/**
+ * Get number of rejected sample
+ *
+ * @return  rejected sample counter
+ */
+uint32_t ZeroTracker::getRejected() const
+{
+    return _rejected;
+}
+
+ZeroTracker::~ZeroTracker()
+{
+}
@@ -0,0 +1,41 @@
+#ifndef ZERO_TRACKER_H
+#define ZERO_TRACKER_H
+
+#include <Arduino.h>
+#include <cc6940.h>
+
+#define ZT_SETTLE_TIME 1000 //time after relay feedback is open before sample is used in ms
+#define ZT_FILTER_SHIFT 10 //filter weight 1 / 2^n for each sample, about 10 s time constant at 100 block / s
+#define ZT_OUTLIER 25 //sample further than this from the estimate is rejected in mV
+#define ZT_MAX_OFFSET 150 //learned offset is limited into +- this from the midpoint in mV
+#define ZT_FRACTION 16 //fraction bit of the estimate
+#define ZT_ONE ((int32_t)1 << ZT_FRACTION) //1 mV in estimate unit
+
+/**
+ * Zero current offset tracker of single CC6940 channel
+ *
+ * @brief   while the channel relay feedback is open the load current is known to be 0 A, so the sensor output is
+ *          its zero point. after the settle time every sample within ZT_OUTLIER of the estimate move the estimate
+ *          by 1 / 2^ZT_FILTER_SHIFT (Q16 fixed point), sample outside it (e.g. wrong feedback, noise spike) is rejected
+ */
+class ZeroTracker
+{
+private:
+    /* data */
+    int32_t _estimate = 0; //offset from midpoint in Q16 mV
+    int32_t _midPoint = 1650;
+    unsigned long _openSince = 0;
+    bool _isOpen = false;
+    uint32_t _accepted = 0;
+    uint32_t _rejected = 0;
+public:
+    ZeroTracker();
+    void begin(const CC6940Config &config); //start from midpoint and offset of the config
+    bool update(uint32_t adcInMillivolts, bool isOpen, uint8_t fractionBits = 0); //add sample in mV / 2^fractionBits, return true if it is used
+    int32_t getOffset() const; //get learned offset in mV, same unit as CC6940Config offset
+    uint32_t getAccepted() const; //get number of accepted sample
+    uint32_t getRejected() const; //get number of rejected sample
+    ~ZeroTracker();
+};
+
+#endif
@@ -0,0 +1,152 @@
+/**
+ * modbus handler benchmark
+ *
+ * Measure per request cost of FC03 / FC04 handler, compare the legacy copy path (getAllParameter + assignHoldingRegister)
+ * against the register bank path which serialize directly from the live register
+ */
+
+#include <Arduino.h>
+#include <LoadParameter.h>
+
+#include <ModbusServerRTU.h>
+#include <loaddefs.h>
+#include <LoadModbusServer.h>
+
+#define LOG_LOCAL_LEVEL ESP_LOG_INFO
+#include "esp_log.h"
+
+#define BENCH_ITERATION 2000
+
+const char* TAG = "bench-modbus";
+
+LoadParameter lp;
+
+LoadModbus::modbusRegister buffRegs;
+LoadModbus::registerBank regBank;
+
+loadParamRegister paramRegs;
+
+LoadModbusServer mbHandler;
+
+// FC03 legacy: copy shadow register into holding register on every request
+ModbusMessage FC03Copy(ModbusMessage request) {
+  uint16_t address;
+  uint16_t words;
+  ModbusMessage response;
+
+  request.get(2, address);
+  request.get(4, words);
+
+  uint16_t offset = 0x1000;
+
+  if (address >= offset && words && ((address + words) - offset) <= buffRegs.holdingRegister.size()) {
+    lp.getAllParameter(paramRegs);
+    buffRegs.assignHoldingRegister(paramRegs);
+    response.add(request.getServerID(), request.getFunctionCode(), (uint8_t)(words * 2));
+    for (uint16_t i = address - offset; i < (address + words) - offset; ++i) {
+      response.add(buffRegs.holdingRegister[i]);
+    }
+  } else {
+    response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_ADDRESS);
+  }
+  return response;
+}
+
+// FC03 register bank: serialize directly from parameter shadow register
+ModbusMessage FC03Bank(ModbusMessage request) {
+  uint16_t address;
+  uint16_t words;
+  ModbusMessage response;
+
+  request.get(2, address);
+  request.get(4, words);
+
+  uint16_t offset = 0x1000;
+
+  if (address >= offset && regBank.holdingRegister.contains(address - offset, words)) {
+    response.add(request.getServerID(), request.getFunctionCode(), (uint8_t)(words * 2));
+    for (uint16_t i = address - offset; i < (address + words) - offset; ++i) {
+      response.add(regBank.holdingRegister[i]);
+    }
+  } else {
+    response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_ADDRESS);
+  }
+  return response;
+}
+
+// FC04 register bank: serialize directly from live telemetry register
+ModbusMessage FC04Bank(ModbusMessage request) {
+  uint16_t address;
+  uint16_t words;
+  ModbusMessage response;
+
+  request.get(2, address);
+  request.get(4, words);
+
+  uint16_t offset = 0x1000;
+
+  if (address >= offset && regBank.inputRegister.contains(address - offset, words)) {
+    response.add(request.getServerID(), request.getFunctionCode(), (uint8_t)(words * 2));
+    for (uint16_t i = address - offset; i < (address + words) - offset; ++i) {
+      response.add(regBank.inputRegister[i]);
+    }
+  } else {
+    response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_ADDRESS);
+  }
+  return response;
+}
+
+/**
+ * run the handler for BENCH_ITERATION times
+ *
+ * @param[in]   name    name of the handler to print
+ * @param[in]   worker  handler to run
+ * @param[in]   request request passed into handler
+ */
+void bench(const char* name, MBSworker worker, ModbusMessage &request)
+{
+  unsigned long start = micros();
+  for (size_t i = 0; i < BENCH_ITERATION; i++)
+  {
+    ModbusMessage response = worker(request);
+  }
+  unsigned long elapsed = micros() - start;
+  ESP_LOGI(TAG, "%s : %.2f us / request\n", name, (float)elapsed / BENCH_ITERATION);
+}
+
+void setup() {
+  Serial.begin(115200);
+  lp.begin("load1", true);
+  regBank.attachHoldingRegister(lp.getShadowRegister().data(), lp.getShadowRegister().size());
+  regBank.attachInputRegister(buffRegs.inputRegister.data(), buffRegs.inputRegister.size());
+  mbHandler.addHoldingRegister(0x1000, regBank.holdingRegister.size, 
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      for (size_t i = 0; i < count; i++)
+      {
+        buff[i] = regBank.holdingRegister[index + i];
+      }
+      return true;
+    });
+  mbHandler.addInputRegister(0x1000, regBank.inputRegister.size, 
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      for (size_t i = 0; i < count; i++)
+      {
+        buff[i] = regBank.inputRegister[index + i];
+      }
+      return true;
+    });
+}
+
+void loop() {
+  ModbusMessage holdingRequest;
+  holdingRequest.add((uint8_t)1, (uint8_t)READ_HOLD_REGISTER, (uint16_t)0x1000, (uint16_t)lp.getShadowRegister().size());
+  ModbusMessage inputRequest;
+  inputRequest.add((uint8_t)1, (uint8_t)READ_INPUT_REGISTER, (uint16_t)0x1000, (uint16_t)buffRegs.inputRegister.size());
+
+  bench("FC03 copy (before)", &FC03Copy, holdingRequest);
+  bench("FC03 register bank (after)", &FC03Bank, holdingRequest);
+  bench("FC04 register bank", &FC04Bank, inputRequest);
+  bench("FC03 LoadModbusServer", [](const ModbusMessage &request) { return mbHandler.readHoldingRegister(request); }, holdingRequest);
+  bench("FC04 LoadModbusServer", [](const ModbusMessage &request) { return mbHandler.readInputRegister(request); }, inputRequest);
+  delay(5000);
+}
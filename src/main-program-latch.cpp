@@ -24,6 +24,23 @@
 #include <pulseoutput.h>
 #include <loaddefs.h>
 #include <cc6940.h>
+#include <FixedScale.h>
+#include <SeqLock.h>
+#include <ChangeTracker.h>
+#include <LoadModbusServer.h>
+#include <RtuBaud.h>
+#include <RelayCommand.h>
+#include <CurrentSampler.h>
+#include <AdsSampler.h>
+#include <FrameAligner.h>
+#include <WindowStats.h>
+#include <EnergyMeter.h>
+#include <ZeroTracker.h>
+#include <CalibrationTable.h>
+#ifdef USE_MODBUS_TCP
+#include <EthernetSave.h>
+#include <LoadModbusTcp.h>
+#endif
 
 #include <CoilData.h>
 
@@ -31,6 +48,27 @@
 #include "esp_log.h"
 
 #define VOLTAGE_MULTIPLIER  18.52
+#define VOLTAGE_STALE_TIMEOUT 100000 //no ADS1115 set within 100 ms is voltage sensor fault, normal period is 5 ms
+#define CURRENT_STALE_TIMEOUT 100000 //no ADC block within 100 ms is current sensor fault, normal period is 10 ms
+
+#define STAT_CHANNEL 10 //load current 1 - 3, load voltage 1 - 3, system voltage, load power 1 - 3
+#define STAT_LEVEL 3 //statistic window level, default 1 s, 1 min and 15 min
+
+#define ENERGY_SAVE_INTERVAL 900000 //save energy total into flash at most every 15 min in normal operation
+
+#define ZERO_SAVE_INTERVAL 3600000 //save learned current offset into flash at most every hour
+
+#define RELAY_CONFIRM_TIMEOUT 500 //maximum time from end of pulse to matching feedback in ms
+
+#define FIRMWARE_VERSION "1.1.0"
+#define CHANNEL_COUNT "3"
+#define STRINGIFY(x) #x
+#define TO_STRING(x) STRINGIFY(x)
+#ifdef BUILD_TARGET
+#define BUILD_TARGET_NAME TO_STRING(BUILD_TARGET)
+#else
+#define BUILD_TARGET_NAME "program-latch"
+#endif
 
 const char* TAG = "load-control";
 
@@ -53,6 +91,11 @@ const char* TAG = "load-control";
  * D23 -> Relay 3 OFF
  * D16 -> RX2
  * D17 -> TX2
+ * D15 -> ADS1115 ALERT/RDY
+ * D14 -> W5500 SCK (USE_MODBUS_TCP)
+ * D35 -> W5500 MISO (USE_MODBUS_TCP)
+ * D4  -> W5500 MOSI (USE_MODBUS_TCP)
+ * D5  -> W5500 CS (USE_MODBUS_TCP)
  */
 
 /**
@@ -105,29 +148,90 @@ struct device_pin {
   
   uint8_t rx2 = 16;
   uint8_t tx2 = 17;
+
+  uint8_t adsAlert = 15;
 } device_pin_t;
 
 //Create signal queue for 3 channel, each queue store 1 signal to ensure that the it is executed once
 QueueHandle_t channelSignalQueue[3] = {xQueueCreate(1, sizeof(Latch::latch_sync_signal_t)), xQueueCreate(1, sizeof(Latch::latch_sync_signal_t)), xQueueCreate(1, sizeof(Latch::latch_sync_signal_t))};
 //Task handle structure
 TaskHandle_t relayTaskHandle;
-TaskHandle_t adsTaskHandle;
+TaskHandle_t autoBaudTaskHandle;
 
 //Object to handle read and store parameter
 LoadParameter lp;
 
 ModbusServerRTU MBserver(2000);
 
+//function code handler shared by all modbus server
+LoadModbusServer mbHandler;
+
+#ifdef USE_MODBUS_TCP
+//Object to handle read and store ethernet setting
+EthernetSave ethernetSave;
+//Modbus TCP server, serve the same register as MBserver
+LoadModbusTcp mbTcp;
+#endif
+
 //Initialize ADS object
 ADS1115 ADS(0x48);
+//ADS1115 conversion driven by ALERT/RDY interrupt, loop read the latest set of every channel
+AdsSampler adsSampler(ADS);
+//integer conversion of ADS1115 count into 0.1 V, built after gain is set
+FixedScale voltageScale;
+//voltage interpolated into current block time for per channel power
+FrameAligner frameAligner;
+
+//windowed statistic fed with every current block, last completed window of each level is published to modbus
+WindowStats<STAT_CHANNEL, STAT_LEVEL> windowStats;
+SeqLockBuffer<WindowStat::stat_snapshot_t<STAT_CHANNEL, STAT_LEVEL>> statSnapshot;
+uint32_t lastCurrentSequence = 0;
+
+//charge and energy of each load integrated from aligned frame, total published to modbus
+EnergyMeter energyMeter;
+SeqLockBuffer<Energy::energy_total_t> energyTotal;
 
 CC6940 cc6940[3];
-
-LoadModbus::modbusRegister buffRegs;
+//integer conversion of current input from mV into 0.01 A, built from cc6940 config
+FixedScale currentScale[3];
+//the same conversion for fine and oversampled input in mV / 2^CS_FINE_BITS
+FixedScale fineScale[3];
+//zero current offset learned while the relay feedback is open, initial offset is the calibrated one
+ZeroTracker zeroTracker[3];
+unsigned long lastZeroSave = 0;
+//learned offset saved by background task so flash write never stall the loop, one pending set is kept
+QueueHandle_t zeroSaveQueue = xQueueCreate(1, sizeof(std::array<int16_t, 3>));
+//last offset queued for saving, INT16_MIN if nothing is stored
+std::array<int16_t, 3> savedZeroOffset;
+
+//piecewise linear calibration of load current 1 - 3 and ADS channel 0 - 3, applied after the integer conversion
+#define CAL_CHANNEL 7
+//tables edited by modbus task, loop read the active copy
+std::array<CalibrationTable, CAL_CHANNEL> calibrationTable;
+SeqLockBuffer<std::array<CalibrationTable, CAL_CHANNEL>> calibrationActive;
+//value before calibration, captured as measured value of new point
+SeqLockBuffer<std::array<int16_t, CAL_CHANNEL>> uncalibrated;
+Preferences calibrationPreferences;
+//capture target written by master before the capture coil
+uint16_t captureChannel = 0;
+int16_t captureReference = 0;
+
+LoadModbus::telemetryRegister buffRegs;
 LoadModbus::FeedbackStatus feedbackStatus;
 LoadModbus::SystemStatus systemStatus;
+LoadModbus::registerBank regBank;
 
-loadParamRegister paramRegs;
+//telemetry published once per loop, modbus worker read consistent snapshot from it
+SeqLockBuffer<LoadModbus::telemetryRegister> telemetry;
+
+//report by exception over extended telemetry block, master read bitmap and fetch only changed register
+ChangeTracker<LoadModbus::EXT_SIZE> changeTracker;
+SeqLockBuffer<LoadModbus::change_state_t<LoadModbus::EXT_SIZE>> changeState;
+//sequence known by the master, written into holding register 0x1200
+uint16_t changeSince = 0;
+
+//continuous ADC1 sampling of the current input, loop read the latest decimated block
+CurrentSampler currentSampler;
 
 LoadHandle loadHandle[3];
 
@@ -145,7 +249,10 @@ PulseOutput relay[6];
 
 OneButton relayFeedback[3];
 
-CoilData myCoils(9);
+//manual relay command written by master, executed by relay task
+RelayCommand relayCommand;
+
+CoilData myCoils(14);
 
 //array to store voltage value from ads
 std::array<int16_t, 4> voltageSense;
@@ -155,222 +262,6 @@ bool relayConnected[3];
 //flag to detect if new parameter exists
 bool isParameterChanged = false;
 
-// FC_01: act on 0x01 requests - READ_COIL
-ModbusMessage FC_01(ModbusMessage request) {
-  ModbusMessage response;
-  // Request parameters are first coil and number of coils to read
-  uint16_t start = 0;
-  uint16_t numCoils = 0;
-  request.get(2, start, numCoils);
-
-  uint16_t offset = 0x1000;
-
-  // Are the parameters valid?
-  if (start >= offset && (start + numCoils) - offset <= myCoils.coils()) {
-    // Looks like it. Get the requested coils from our storage
-    vector<uint8_t> coilset = myCoils.slice(start - offset, numCoils);
-    // Set up response according to the specs: serverID, function code, number of bytes to follow, packed coils
-    response.add(request.getServerID(), request.getFunctionCode(), (uint8_t)coilset.size(), coilset);
-  } else {
-    // Something was wrong with the parameters
-    response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_ADDRESS);
-  }
-  // Return the response
-  return response;
-}
-
-// FC05: act on 0x05 requests - WRITE_COIL
-ModbusMessage FC_05(ModbusMessage request) {
-  ModbusMessage response;
-  // Request parameters are coil number and 0x0000 (OFF) or 0xFF00 (ON)
-  uint16_t start = 0;
-  uint16_t state = 0;
-  request.get(2, start, state);
-
-  uint16_t offset = 0x1000;
-
-  // Is the coil number valid?
-  if (start >= offset && (start - offset) <= myCoils.coils()) {
-    // Looks like it. Is the ON/OFF parameter correct?
-    if (state == 0x0000 || state == 0xFF00) {
-      // Yes. We can set the coil
-      if (myCoils.set(start - offset, state)) {
-        // All fine, coil was set.
-        response = ECHO_RESPONSE;
-      } else {
-        // Setting the coil failed
-        response.setError(request.getServerID(), request.getFunctionCode(), SERVER_DEVICE_FAILURE);
-      }
-    } else {
-      // Wrong data parameter
-      response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_VALUE);
-    }
-  } else {
-    // Something was wrong with the coil number
-    response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_ADDRESS);
-  }
-  // Return the response
-  return response;
-}
-
-// FC03: worker do serve Modbus function code 0x03 (READ_HOLD_REGISTER)
-ModbusMessage FC03(ModbusMessage request) {
-  uint16_t address;           // requested register address
-  uint16_t words;             // requested number of registers
-  ModbusMessage response;     // response message to be sent back
-
-  // get request values
-  request.get(2, address);
-  request.get(4, words);
-
-  uint16_t offset = 0x1000;
-
-  // Address and words valid? We assume 10 registers here for demo
-  if (address >= offset && words && ((address + words) - offset) <= buffRegs.holdingRegister.size()) {
-    // lp.printShadow();
-    buffRegs.assignHoldingRegister(paramRegs);
-    // Looks okay. Set up message with serverID, FC and length of data
-    response.add(request.getServerID(), request.getFunctionCode(), (uint8_t)(words * 2));
-    // Fill response with requested data
-    for (uint16_t i = address - offset; i < (address + words) - offset; ++i) {
-      response.add(buffRegs.holdingRegister[i]);
-    }
-  } else {
-    // No, either address or words are outside the limits. Set up error response.
-    response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_ADDRESS);
-  }
-  return response;
-}
-
-// FC04: worker do serve Modbus function code 0x04 (READ_INPUT_REGISTER)
-ModbusMessage FC04(ModbusMessage request) {
-  uint16_t address;           // requested register address
-  uint16_t words;             // requested number of registers
-  ModbusMessage response;     // response message to be sent back
-
-  // get request values
-  request.get(2, address);
-  request.get(4, words);
-
-  uint16_t offset = 0x1000;
-
-  // Address and words valid? We assume 10 registers here for demo
-  if (address >= offset && words && ((address + words) - offset) <= buffRegs.inputRegister.size()) {
-    // Looks okay. Set up message with serverID, FC and length of data
-    response.add(request.getServerID(), request.getFunctionCode(), (uint8_t)(words * 2));
-    // Fill response with requested data
-    for (uint16_t i = address - offset; i < (address + words) - offset; ++i) {
-      response.add(buffRegs.inputRegister[i]);
-    }
-  } else {
-    // No, either address or words are outside the limits. Set up error response.
-    response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_ADDRESS);
-  }
-  return response;
-}
-
-// FC06: worker do serve Modbus function code 0x06 (WRITE_HOLD_REGISTER)
-ModbusMessage FC06(ModbusMessage request) {
-  uint16_t address;           // requested register address
-  uint16_t data;              // value to be written
-  ModbusMessage response;     // response message to be sent back
-
-  // get request values
-  request.get(2, address);
-  request.get(4, data);
-
-  uint16_t offset = 0x1000;
-
-  // Address valid?
-  if (address >= offset) {
-    lp.writeSingle(address-offset, data);
-    lp.getAllParameter(paramRegs);
-    // Looks okay. Set up message with serverID, FC, address and data
-    response.add(request.getServerID(), request.getFunctionCode(), address, data);
-    isParameterChanged = true;
-  } else {
-    // No, either address or words are outside the limits. Set up error response.
-    response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_ADDRESS);
-  }
-  return response;
-}
-
-// FC0F: act on 0x0F requests - WRITE_MULT_COILS
-ModbusMessage FC_0F(ModbusMessage request) {
-  ModbusMessage response;
-  // Request parameters are first coil to be set, number of coils, number of bytes and packed coil bytes
-  uint16_t start = 0;
-  uint16_t numCoils = 0;
-  uint8_t numBytes = 0;
-  uint16_t offset = 2;    // Parameters start after serverID and FC
-  offset = request.get(offset, start, numCoils, numBytes);
-
-  uint16_t addrOffset = 0x1000;
-
-  // Check the parameters so far
-  if (start >= addrOffset && numCoils && (start + numCoils) - addrOffset <= myCoils.coils()) {
-    // Packed coils will fit in our storage
-    if (numBytes == ((numCoils - 1) >> 3) + 1) {
-      // Byte count seems okay, so get the packed coil bytes now
-      vector<uint8_t> coilset;
-      request.get(offset, coilset, numBytes);
-      // Now set the coils
-      if (myCoils.set(start - addrOffset, numCoils, coilset)) {
-        // All fine, return shortened echo response, like the standard says
-        response.add(request.getServerID(), request.getFunctionCode(), start, numCoils);
-      } else {
-        // Oops! Setting the coils seems to have failed
-        response.setError(request.getServerID(), request.getFunctionCode(), SERVER_DEVICE_FAILURE);
-      }
-    } else {
-      // numBytes had a wrong value
-      response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_VALUE);
-    }
-  } else {
-    // The given set will not fit to our coil storage
-    response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_ADDRESS);
-  }
-  return response;
-}
-
-// FC10: worker do serve Modbus function code 0x10 (WRITE_MULT_REGISTERS)
-ModbusMessage FC10(ModbusMessage request) {
-  uint16_t address;           // requested register address
-  uint16_t words;             // requested number of registers
-  uint8_t bytes;
-  ModbusMessage response;     // response message to be sent back
-
-  // get request values
-  request.get(2, address);
-  request.get(4, words);
-  uint16_t index = request.get(6, bytes);
-
-  uint16_t offset = 0x1000;
-
-  // Address and words valid? We assume 10 registers here for demo
-  if (address >= offset && words && ((address + words) - offset) <= buffRegs.holdingRegister.size()) {
-    std::vector<uint16_t> dataVec;
-    dataVec.reserve(128); 
-    for (size_t i = 0; i < words; i++)
-    {
-      uint16_t data = 0;
-      index = request.get(index, data);
-      dataVec.push_back(data);
-    }
-    
-    lp.writeMultiple(address-offset, dataVec.size(), dataVec.data());
-    lp.getAllParameter(paramRegs);
-    
-    // Looks okay. Set up message with serverID, FC and length of data
-    response.add(request.getServerID(), request.getFunctionCode(), address, words);
-    isParameterChanged = true;
-  } else {
-    // No, either address or words are outside the limits. Set up error response.
-    response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_ADDRESS);
-  }
-  return response;
-}
-
 //callback when relay state feedback 1 is on
 void relayFeedbackLongPressStart1()
 {
@@ -555,6 +446,36 @@ void processSignal(Latch::latch_sync_signal_t &signal)
   }
 }
 
+/**
+ * Process manual relay command, pulse the relay and wait for the feedback to confirm it
+ * 
+ * @param[in]   command relay command from master
+ */
+void processCommand(LoadModbus::relay_command_t &command)
+{
+  if (!myCoils[6]) //switched back into auto while the command is queued
+  {
+    relayCommand.setState(command.sequence, LoadModbus::CMD_FAILED);
+    return;
+  }
+
+  relayCommand.setState(command.sequence, LoadModbus::CMD_PULSING);
+  relay[command.relay].set();
+  while (relay[command.relay].isRunning()) //wait pulse to end
+  {
+    delay(1);
+  }
+
+  size_t channel = command.relay / 2;
+  bool isOn = command.relay % 2 == 0; //even relay is ON pulse
+  unsigned long start = millis();
+  while (relayConnected[channel] != isOn && millis() - start < RELAY_CONFIRM_TIMEOUT)
+  {
+    delay(1);
+  }
+  relayCommand.setState(command.sequence, relayConnected[channel] == isOn ? LoadModbus::CMD_CONFIRMED : LoadModbus::CMD_FAILED);
+}
+
 /**
  * Task to handle relay
  * 
@@ -588,32 +509,86 @@ void relayTask(void *pvParameter)
     {
       processSignal(signal);
     }
+
+    /**
+     * Get manual relay command written by master
+     */
+    LoadModbus::relay_command_t command;
+    if (relayCommand.receive(command, 10))
+    {
+      processCommand(command);
+    }
     //no need delay, since the xQueueReceive already has waiting time
   }
 }
 
 /**
- * Task to read voltage measurement on ADS1115 
+ * Apply group command into coil, executed by loop like the coil written by master
+ * 
+ * @param[in]   command group command, refer to LoadModbus::GroupCommand
  */
-void adsTask(void *pvParameter)
+void applyGroupCommand(uint16_t command)
 {
-  const char* _TAG = "ads-task";
-  voltageSense.fill(0);
+  switch (command)
+  {
+  case LoadModbus::GROUP_MANUAL:
+    myCoils.set(6, true);
+    break;
+  case LoadModbus::GROUP_AUTO:
+    myCoils.set(6, false);
+    break;
+  case LoadModbus::GROUP_SHED:
+    myCoils.set(10, true);
+    break;
+  case LoadModbus::GROUP_RECONNECT:
+    myCoils.set(11, true);
+    break;
+  default:
+    break;
+  }
+}
+
+/**
+ * task to save learned current offset into flash, only changed offset is written
+ */
+void zeroSaveTask(void *pvParameter)
+{
+  std::array<int16_t, 3> offset;
   while (1)
   {
-    
-    // float f = ADS.toVoltage(VOLTAGE_MULTIPLIER);  //  voltage factor
-    float f = ADS.toVoltage(1);  //  voltage factor
-    for (size_t i = 0; i < voltageSense.size(); i++)
+    if (xQueueReceive(zeroSaveQueue, &offset, portMAX_DELAY) == pdTRUE)
     {
-      int16_t rawAdc = ADS.readADC(i);
-      voltageSense[i] = (int16_t)rawAdc*f*10*VOLTAGE_MULTIPLIER;
-      ESP_LOGI(TAG, "raw voltage analog %d = %d, voltage = %.2f V", i, rawAdc, rawAdc*f*VOLTAGE_MULTIPLIER);
-    }    
-    delay(10); //delay to give another task time to execute
+      for (size_t i = 0; i < 3; i++)
+      {
+        if (offset[i] != INT16_MIN && lp.getCurrentOffset(i, INT16_MIN) != offset[i])
+        {
+          lp.setCurrentOffset(i, offset[i]);
+        }
+      }
+    }
   }
 }
 
+/**
+ * Task to detect master baudrate
+ * 
+ * @brief used when baudrate code is BAUDRATE_AUTO, listen on every baudrate until a valid frame is received,
+ *        then start the RTU server with the detected baudrate. the detected frame is not answered
+ */
+void autoBaudTask(void *pvParameter)
+{
+  const char* _TAG = "auto-baud-task";
+  RtuBaud rtuBaud;
+  uint32_t baud = 0;
+  while (baud == 0)
+  {
+    baud = rtuBaud.detect(Serial2, 1000); //two frame of the master poll
+  }
+  MBserver.begin(Serial2, -1, RtuBaud::getInterval(baud));
+  ESP_LOGI(_TAG, "modbus rtu started on %d bps\n", baud);
+  vTaskDelete(NULL);
+}
+
 void scanner() {
   byte error, address;
   int nDevices;
@@ -655,6 +630,30 @@ void scanner() {
   delay(5000);           // wait 5 seconds for next scan
 }
 
+/**
+ * Apply energy flush threshold, system voltage 20% below undervoltage disconnect mean the supply is failing
+ */
+void updateEnergySag()
+{
+  uint16_t undervoltage = lp.getUndervoltageDisconnect1();
+  energyMeter.setSagThreshold(undervoltage * 8 / 10, undervoltage);
+}
+
+/**
+ * Apply statistic window length stored in FLASH, only changed level is restarted
+ */
+void updateStatWindow()
+{
+  for (size_t i = 0; i < STAT_LEVEL; i++)
+  {
+    uint32_t window = lp.getStatWindow(i) * 1000UL;
+    if (windowStats.getWindow(i) != window)
+    {
+      windowStats.setWindow(i, window, millis());
+    }
+  }
+}
+
 void setup() {
   // put your setup code here, to run once:
   esp_log_level_set(TAG, ESP_LOG_INFO);
@@ -724,7 +723,7 @@ void setup() {
   latchHandle[2].onSignal(&channelOnSignal3); //register the callback handler when latchhandle produce signal
 
   Serial.begin(115200);
-  lp.begin("load1");
+  lp.begin("load1", true); //fast boot, parameter is printed in background so protection can start early
   /**
    * this code block is used to clear all the internal setting parameter, uncomment this block and upload into your board
    * after that, comment again and re-upload, this will ensure that the existing parameter will be deleted
@@ -734,31 +733,27 @@ void setup() {
   // {
   //   /* code */
   // }
-  
-  ESP_LOGI(TAG, "baudrate bps = %d\n", lp.getBaudrateBps());
-  ESP_LOGI(TAG, "written = %d\n", lp.getAllParameter(paramRegs));
-
-  RTUutils::prepareHardwareSerial(Serial2);
-  Serial2.begin(lp.getBaudrateBps());
-
-  // Serial2.begin(lp.getBaudrateBps(), SERIAL_8N1, device_pin_t.rx2, device_pin_t.tx2);
-  // Serial2.begin(115200, SERIAL_8N1, device_pin_t.rx2, device_pin_t.tx2);
-  Wire.begin(device_pin_t.sda, device_pin_t.scl);
-  ADS.begin();
-  ADS.setGain(0);
-  // SPI.begin(device_pin_t.sck, device_pin_t.miso, device_pin_t.mosi, device_pin_t.ss);
-
-  MBserver.registerWorker(lp.getId(), READ_COIL, &FC_01);
-  MBserver.registerWorker(lp.getId(), WRITE_COIL, &FC_05);
-  MBserver.registerWorker(lp.getId(), WRITE_MULT_COILS, &FC_0F);
-  MBserver.registerWorker(lp.getId(), READ_HOLD_REGISTER, &FC03);
-  MBserver.registerWorker(lp.getId(), READ_INPUT_REGISTER, &FC04);
-  MBserver.registerWorker(lp.getId(), WRITE_MULT_REGISTERS, &FC10);
-  MBserver.begin(Serial2);
-
-  xTaskCreate(&relayTask, "relay task", 2048, NULL, 8, &relayTaskHandle);
-  xTaskCreate(&adsTask, "ads task", 2048, NULL, 8, &adsTaskHandle);
 
+  for (size_t i = 0; i < 3; i++) //learned offset replace the calibrated one once it is stored
+  {
+    CC6940Config config = cc6940[i].getCurrentConfig();
+    savedZeroOffset[i] = lp.getCurrentOffset(i, INT16_MIN);
+    config.offset = lp.getCurrentOffset(i, config.offset);
+    cc6940[i].setup(config);
+    currentScale[i] = FixedScale::fromCC6940(config);
+    fineScale[i] = FixedScale::fromCC6940(config, CS_FINE_BITS);
+    zeroTracker[i].begin(config);
+    currentSampler.setOversampling(i, lp.getOversampling(i));
+  }
+  calibrationPreferences.begin("calib");
+  for (size_t i = 0; i < CAL_CHANNEL; i++)
+  {
+    char key[8];
+    snprintf(key, sizeof(key), "t%d", (int)i);
+    calibrationTable[i].load(calibrationPreferences, key);
+  }
+  calibrationActive.publish(calibrationTable);
+  
   /**
    * load paramater from flash memory and pass it into loadHandle
    */
@@ -774,6 +769,7 @@ void setup() {
   s.loadShortCircuitDetectionTime = lp.getShortCircuitDetectionTime1();
   s.loadShortCircuitReconnectTime = lp.getShortCircuitReconnectInterval1();
   s.activeLow = lp.getOutputMode1();
+  s.loadOverpowerDisconnect = lp.getOverpowerDisconnect(0);
   loadHandle[0].setParams(s);
 
   s.loadOverVoltageDisconnect = lp.getOvervoltageDisconnect2();
@@ -787,6 +783,7 @@ void setup() {
   s.loadShortCircuitDetectionTime = lp.getShortCircuitDetectionTime2();
   s.loadShortCircuitReconnectTime = lp.getShortCircuitReconnectInterval2();
   s.activeLow = lp.getOutputMode2();
+  s.loadOverpowerDisconnect = lp.getOverpowerDisconnect(1);
   loadHandle[1].setParams(s);
 
   s.loadOverVoltageDisconnect = lp.getOvervoltageDisconnect3();
@@ -800,7 +797,370 @@ void setup() {
   s.loadShortCircuitDetectionTime = lp.getShortCircuitDetectionTime3();
   s.loadShortCircuitReconnectTime = lp.getShortCircuitReconnectInterval3();
   s.activeLow = lp.getOutputMode3();
+  s.loadOverpowerDisconnect = lp.getOverpowerDisconnect(2);
   loadHandle[2].setParams(s);
+  updateStatWindow();
+  energyMeter.begin("energy", ENERGY_SAVE_INTERVAL);
+  updateEnergySag();
+  energyTotal.publish(energyMeter.getTotal());
+
+  ESP_LOGI(TAG, "baudrate bps = %d\n", lp.getBaudrateBps());
+  regBank.attachHoldingRegister(lp.getShadowRegister().data(), lp.getShadowRegister().size());
+
+  RTUutils::prepareHardwareSerial(Serial2);
+  Serial2.begin(lp.getBaudrateBps());
+
+  // Serial2.begin(lp.getBaudrateBps(), SERIAL_8N1, device_pin_t.rx2, device_pin_t.tx2);
+  // Serial2.begin(115200, SERIAL_8N1, device_pin_t.rx2, device_pin_t.tx2);
+  Wire.begin(device_pin_t.sda, device_pin_t.scl);
+  Wire.setClock(400000); //shorter I2C transaction between conversion
+  ADS.begin();
+  ADS.setGain(0);
+  voltageScale = FixedScale::fromVoltageFactor(ADS.toVoltage(1), VOLTAGE_MULTIPLIER);
+  for (size_t i = 0; i < 3; i++)
+  {
+    frameAligner.setLoadVoltage(i, 2 - i); //load 1 voltage is ADS channel 2, load 3 is channel 0
+  }
+  voltageSense.fill(0);
+  // SPI.begin(device_pin_t.sck, device_pin_t.miso, device_pin_t.mosi, device_pin_t.ss);
+
+  relayCommand.begin();
+  xTaskCreate(&relayTask, "relay task", 2048, NULL, 8, &relayTaskHandle);
+  xTaskCreate(&zeroSaveTask, "zero save task", 2560, NULL, 3, NULL);
+  if (!adsSampler.begin(device_pin_t.adsAlert))
+  {
+    ESP_LOGE(TAG, "ads sampler failed to start\n");
+  }
+  if (!currentSampler.begin({device_pin_t.currentIn1, device_pin_t.currentIn2, device_pin_t.currentIn3}))
+  {
+    ESP_LOGE(TAG, "current sampler failed to start\n");
+  }
+
+  changeTracker.setDeadband(LoadModbus::EXT_SYSTEM_VOLTAGE, 4, 2); //0.2 V
+  changeTracker.setDeadband(LoadModbus::EXT_LOAD_CURRENT_1, 3, 5); //0.05 A
+  changeTracker.setDeadband(LoadModbus::EXT_UPTIME, 2, 0xFFFF); //uptime change every second, never report
+  changeTracker.setDeadband(LoadModbus::EXT_LOAD_POWER_1, 3, 10); //1 W
+
+  /**
+   * Modbus register map, all address start from 0x1000
+   * 
+   * holding register : parameter shadow register, change since sequence at 0x1200
+   *                    group mask at 0x1400, group command for group 0 - 15 at 0x1410
+   *                    relay command at 0x1500, write relay index and read back its sequence with FC17
+   *                    overpower disconnect of load 1 - 3 in 0.1 W at 0x1600, 0 is disabled
+   *                    statistic window length of level 1 - 3 in seconds at 0x1700, 0 is disabled
+   *                    calibration table at 0x1900, 17 register for each channel (load current 1 - 3, ADS channel 0 - 3),
+   *                    number of point followed by measured and reference value of each point sorted by measured value
+   *                    capture channel and reference value at 0x1980, point is added by capture coil
+   *                    current oversampling of load 1 - 3 at 0x1A00, number of block (1 - 16) averaged into load current
+   *                    telemetry, protection always use the latest block
+   * input register : telemetry snapshot, extended telemetry block start from 0x1100 (boot time at 0x110D, load power at 0x111C)
+   *                  change sequence and changed bitmap of extended block at 0x1200
+   *                  function code and bus diagnostic at 0x1300
+   *                  relay command status at 0x1500
+   *                  windowed statistic at 0x1700, each level is window sequence followed by mean, rms, min, max of
+   *                  load current 1 - 3, load voltage 1 - 3, system voltage and load power 1 - 3
+   *                  energy at 0x1800, each load is charge in mAh and energy in 0.01 Wh as 32 bit signed pair
+   *                  value before calibration of each calibration channel at 0x1900
+   *                  effective bit gained by current oversampling of load 1 - 3 at 0x1A00
+   * coil : manual relay, manual mode, restart, factory reset, diagnostic reset, shed all, reconnect all, energy reset
+   *        and calibration capture. factory reset restore every parameter above to its default but keep the learned
+   *        current zero offset, it describe the sensor rather than a setting and is relearned while the relay is open
+   * broadcast (unit 0) : manual mode, shed all and reconnect all coil, group command register
+   * device identification (FC2B/0E) : firmware version, build target and channel count (extended object 0x80)
+   */
+  mbHandler.addHoldingRegister(0x1000, regBank.holdingRegister.size, 
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      for (size_t i = 0; i < count; i++)
+      {
+        buff[i] = regBank.holdingRegister[index + i];
+      }
+      return true;
+    },
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      lp.writeMultiple(index, count, buff);
+      isParameterChanged = true;
+      return true;
+    });
+  mbHandler.addInputRegister(0x1000, buffRegs.inputRegister.size(), 
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      LoadModbus::telemetryRegister snapshot;
+      telemetry.read(snapshot); //all register come from the same loop
+      memcpy(buff, snapshot.inputRegister.data() + index, count * sizeof(uint16_t));
+      return true;
+    });
+  mbHandler.addInputRegister(0x1100, buffRegs.extendedRegister.size(), 
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      LoadModbus::telemetryRegister snapshot;
+      telemetry.read(snapshot);
+      memcpy(buff, snapshot.extendedRegister.data() + index, count * sizeof(uint16_t));
+      return true;
+    });
+  mbHandler.addHoldingRegister(0x1200, 1, 
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      buff[0] = changeSince;
+      return true;
+    },
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      changeSince = buff[0];
+      return true;
+    });
+  mbHandler.addInputRegister(0x1200, 1 + (LoadModbus::EXT_SIZE + 15) / 16, 
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      LoadModbus::change_state_t<LoadModbus::EXT_SIZE> state;
+      uint16_t regs[1 + (LoadModbus::EXT_SIZE + 15) / 16];
+      changeState.read(state);
+      regs[0] = state.sequence; //0x1200 : current change sequence
+      state.getBitmap(changeSince, regs + 1, (LoadModbus::EXT_SIZE + 15) / 16); //0x1201 : bit n set if 0x1100 + n changed
+      memcpy(buff, regs + index, count * sizeof(uint16_t));
+      return true;
+    });
+  mbHandler.addInputRegister(0x1300, LMS_STAT_SIZE, 
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      return mbHandler.readStatistic(index, count, buff);
+    });
+  mbHandler.addHoldingRegister(0x1400, 1, 
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      buff[0] = lp.getGroup();
+      return true;
+    },
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      lp.setGroup(buff[0]);
+      return true;
+    });
+  mbHandler.addHoldingRegister(0x1410, 16, 
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      memset(buff, 0, count * sizeof(uint16_t)); //write only
+      return true;
+    },
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      for (size_t i = 0; i < count; i++)
+      {
+        if (lp.getGroup() & (1 << (index + i)))
+        {
+          applyGroupCommand(buff[i]);
+        }
+      }
+      return true;
+    });
+  mbHandler.addHoldingRegister(0x1500, 1, 
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      buff[0] = relayCommand.getSequence();
+      return true;
+    },
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      if (buff[0] >= 6)
+      {
+        return false;
+      }
+      relayCommand.push(buff[0], myCoils[6]); //rejected in auto mode
+      return true;
+    });
+  mbHandler.addInputRegister(0x1500, RC_REGISTER_SIZE, 
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      return relayCommand.readRegister(index, count, buff);
+    });
+  mbHandler.addHoldingRegister(0x1600, 3, 
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      for (size_t i = 0; i < count; i++)
+      {
+        buff[i] = lp.getOverpowerDisconnect(index + i);
+      }
+      return true;
+    },
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      for (size_t i = 0; i < count; i++)
+      {
+        lp.setOverpowerDisconnect(index + i, buff[i]);
+      }
+      isParameterChanged = true;
+      return true;
+    });
+  mbHandler.addHoldingRegister(0x1700, STAT_LEVEL, 
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      for (size_t i = 0; i < count; i++)
+      {
+        buff[i] = lp.getStatWindow(index + i);
+      }
+      return true;
+    },
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      for (size_t i = 0; i < count; i++)
+      {
+        lp.setStatWindow(index + i, buff[i]);
+      }
+      isParameterChanged = true;
+      return true;
+    });
+  mbHandler.addInputRegister(0x1700, WindowStat::stat_snapshot_t<STAT_CHANNEL, STAT_LEVEL>::size, 
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      WindowStat::stat_snapshot_t<STAT_CHANNEL, STAT_LEVEL> snapshot;
+      statSnapshot.read(snapshot);
+      return snapshot.readRegister(index, count, buff);
+    });
+  mbHandler.addInputRegister(0x1800, EM_REGISTER_SIZE, 
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      Energy::energy_total_t total;
+      energyTotal.read(total);
+      return total.readRegister(index, count, buff);
+    });
+  mbHandler.addHoldingRegister(0x1900, CAL_CHANNEL * CT_REGISTER_SIZE, 
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      for (size_t i = 0; i < count; i++)
+      {
+        calibrationTable[(index + i) / CT_REGISTER_SIZE].readRegister((index + i) % CT_REGISTER_SIZE, 1, buff + i);
+      }
+      return true;
+    },
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      size_t first = index / CT_REGISTER_SIZE;
+      size_t last = (index + count - 1) / CT_REGISTER_SIZE;
+      std::array<CalibrationTable, CAL_CHANNEL> tables = calibrationTable;
+      for (size_t i = first; i <= last; i++) //every touched table must stay valid
+      {
+        uint16_t start = i == first ? index % CT_REGISTER_SIZE : 0;
+        uint16_t end = i == last ? (index + count - 1) % CT_REGISTER_SIZE + 1 : CT_REGISTER_SIZE;
+        if (!tables[i].writeRegister(start, end - start, buff + (i * CT_REGISTER_SIZE + start - index)))
+        {
+          return false;
+        }
+      }
+      for (size_t i = first; i <= last; i++)
+      {
+        char key[8];
+        snprintf(key, sizeof(key), "t%d", (int)i);
+        tables[i].save(calibrationPreferences, key);
+      }
+      calibrationTable = tables;
+      calibrationActive.publish(calibrationTable);
+      return true;
+    });
+  mbHandler.addHoldingRegister(0x1980, 2, 
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      uint16_t regs[2] = {captureChannel, (uint16_t)captureReference};
+      memcpy(buff, regs + index, count * sizeof(uint16_t));
+      return true;
+    },
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      uint16_t regs[2] = {captureChannel, (uint16_t)captureReference};
+      memcpy(regs + index, buff, count * sizeof(uint16_t));
+      if (regs[0] >= CAL_CHANNEL)
+      {
+        return false;
+      }
+      captureChannel = regs[0];
+      captureReference = regs[1];
+      return true;
+    });
+  mbHandler.addHoldingRegister(0x1A00, 3, 
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      for (size_t i = 0; i < count; i++)
+      {
+        buff[i] = lp.getOversampling(index + i);
+      }
+      return true;
+    },
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      for (size_t i = 0; i < count; i++)
+      {
+        if (buff[i] < 1 || buff[i] > CS_MAX_OVERSAMPLE)
+        {
+          return false;
+        }
+      }
+      for (size_t i = 0; i < count; i++)
+      {
+        lp.setOversampling(index + i, buff[i]);
+        currentSampler.setOversampling(index + i, buff[i]); //history restart on the next block
+      }
+      return true;
+    });
+  mbHandler.addInputRegister(0x1A00, 3, 
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      CurrentSense::sample_block_t block;
+      currentSampler.read(block);
+      for (size_t i = 0; i < count; i++)
+      {
+        buff[i] = block.extraBits[index + i];
+      }
+      return true;
+    });
+  mbHandler.addInputRegister(0x1900, CAL_CHANNEL, 
+    [](uint16_t index, uint16_t count, uint16_t *buff) {
+      std::array<int16_t, CAL_CHANNEL> value;
+      uncalibrated.read(value);
+      memcpy(buff, value.data() + index, count * sizeof(uint16_t));
+      return true;
+    });
+  mbHandler.setCoil(0x1000, &myCoils);
+  mbHandler.setCoilHandler([](uint16_t index, bool value) {
+    if (index == 13) //capture latest value before calibration as point of the selected channel
+    {
+      if (!value)
+      {
+        return true;
+      }
+      std::array<int16_t, CAL_CHANNEL> measured;
+      uncalibrated.read(measured);
+      if (!calibrationTable[captureChannel].insert(measured[captureChannel], captureReference))
+      {
+        ESP_LOGW(TAG, "calibration table %d is full\n", captureChannel);
+        return true;
+      }
+      char key[8];
+      snprintf(key, sizeof(key), "t%d", (int)captureChannel);
+      calibrationTable[captureChannel].save(calibrationPreferences, key);
+      calibrationActive.publish(calibrationTable);
+      return true;
+    }
+    if (index >= 6) //only manual relay coil is event driven
+    {
+      return false;
+    }
+    if (value)
+    {
+      relayCommand.push(index, myCoils[6]); //rejected in auto mode
+    }
+    return true;
+  });
+  mbHandler.addBroadcastCoil(0x1006, 1); //manual mode
+  mbHandler.addBroadcastCoil(0x100A, 2); //shed all, reconnect all
+  mbHandler.addBroadcastRegister(0x1410, 16); //group command
+  mbHandler.setDeviceObject(LoadModbus::VENDOR_NAME, "Load Control");
+  mbHandler.setDeviceObject(LoadModbus::PRODUCT_CODE, BUILD_TARGET_NAME);
+  mbHandler.setDeviceObject(LoadModbus::MAJOR_MINOR_REVISION, FIRMWARE_VERSION);
+  mbHandler.setDeviceObject(LoadModbus::PRODUCT_NAME, "Latch Load Controller");
+  mbHandler.setDeviceObject(LoadModbus::EXTENDED_OBJECT, CHANNEL_COUNT);
+  mbHandler.registerWorker(MBserver, lp.getId());
+  mbHandler.setPollTimeout(2000);
+  MBserver.registerSniffer([](const ModbusMessage &msg) {
+    mbHandler.countFrame(msg, lp.getId());
+  });
+  MBserver.registerBroadcastWorker([](const ModbusMessage &msg) {
+    mbHandler.serveBroadcast(msg);
+  });
+  if (lp.isAutoBaudrate())
+  {
+    xTaskCreate(&autoBaudTask, "auto baud task", 3072, NULL, 2, &autoBaudTaskHandle);
+  }
+  else
+  {
+    MBserver.begin(Serial2, -1, RtuBaud::getInterval(lp.getBaudrateBps())); //t3.5 follow the baudrate
+  }
+
+#ifdef USE_MODBUS_TCP
+  ethernetSave.begin("eth");
+  LoadModbus::modbus_tcp_config_t tcpConfig;
+  if (!mbTcp.begin(ethernetSave, mbHandler, lp.getId(), tcpConfig))
+  {
+    ESP_LOGE(TAG, "modbus tcp is not started, only RTU is available\n");
+  }
+#endif
+
+  unsigned long bootTime = millis();
+  buffRegs.assignBootTime(bootTime > UINT16_MAX ? UINT16_MAX : bootTime); //boot to ready time in ms
+  telemetry.publish(buffRegs);
+  ESP_LOGI(TAG, "reset reason = %d, ready in %lu ms\n", esp_reset_reason(), bootTime);
 }
 
 /**
@@ -820,6 +1180,7 @@ void updateParameter()
   s.loadShortCircuitDetectionTime = lp.getShortCircuitDetectionTime1();
   s.loadShortCircuitReconnectTime = lp.getShortCircuitReconnectInterval1();
   s.activeLow = lp.getOutputMode1();
+  s.loadOverpowerDisconnect = lp.getOverpowerDisconnect(0);
   loadHandle[0].setParams(s);
   loadHandle[0].printParams();
 
@@ -834,6 +1195,7 @@ void updateParameter()
   s.loadShortCircuitDetectionTime = lp.getShortCircuitDetectionTime2();
   s.loadShortCircuitReconnectTime = lp.getShortCircuitReconnectInterval2();
   s.activeLow = lp.getOutputMode2();
+  s.loadOverpowerDisconnect = lp.getOverpowerDisconnect(1);
   loadHandle[1].setParams(s);
   loadHandle[1].printParams();
 
@@ -848,8 +1210,11 @@ void updateParameter()
   s.loadShortCircuitDetectionTime = lp.getShortCircuitDetectionTime3();
   s.loadShortCircuitReconnectTime = lp.getShortCircuitReconnectInterval3();
   s.activeLow = lp.getOutputMode3();
+  s.loadOverpowerDisconnect = lp.getOverpowerDisconnect(2);
   loadHandle[2].setParams(s);
   loadHandle[2].printParams();
+  updateStatWindow();
+  updateEnergySag();
 }
 
 void loop() {
@@ -868,17 +1233,99 @@ void loop() {
     isParameterChanged = false;
   }
 
+  CurrentSense::sample_block_t currentBlock;
+  uint32_t currentTime = 0;
+  uint32_t currentSequence = currentSampler.read(currentBlock, currentTime); // latest block average of each current load, in millivolts
   uint32_t raw[3];
-  raw[0] = analogReadMilliVolts(device_pin_t.currentIn1); // current load 1, reading the value as millivolts
-  raw[1] = analogReadMilliVolts(device_pin_t.currentIn2); // current load 2, reading the value as millivolts
-  raw[2] = analogReadMilliVolts(device_pin_t.currentIn3); // current load 3, reading the value as millivolts
+  for (size_t i = 0; i < 3; i++)
+  {
+    raw[i] = currentBlock.mean[i];
+  }
+
+  std::array<int16_t, 3> current; //protection, power and energy use the latest block only
+  std::array<int16_t, 3> averageCurrent; //telemetry, averaged over the oversampling length
+  for (size_t i = 0; i < 3; i++)
+  {
+    current[i] = fineScale[i].convert(currentBlock.fine[i]); //fine mV into 0.01 A
+    averageCurrent[i] = fineScale[i].convert(currentBlock.oversampled[i]);
+    ESP_LOGI(TAG, "raw current analog value %d = %d, current %d = %d x 0.01 A", i+1, raw[i], i+1, current[i]);
+  }
+
+  VoltageSense::sample_set_t voltageSet;
+  uint32_t voltageSequence = adsSampler.read(voltageSet); // latest conversion of each ADS1115 channel
+  voltageScale.convert(voltageSet.raw.data(), voltageSense.data(), voltageSense.size()); //ADC count into 0.1 V
 
-  int16_t current[3];
+  //correct sensor gain and non linearity, offset is already tracked in the conversion
+  std::array<CalibrationTable, CAL_CHANNEL> calibration;
+  calibrationActive.read(calibration);
+  std::array<int16_t, CAL_CHANNEL> measured;
   for (size_t i = 0; i < 3; i++)
   {
-    float resultCurrent = (cc6940[i].getCurrent(raw[i]));
-    current[i] = resultCurrent * 100;
-    ESP_LOGI(TAG, "raw current analog value %d = %d, current %d = %.2f", i+1, raw[i], i+1, resultCurrent);
+    measured[i] = averageCurrent[i]; //less noise for captured point
+    current[i] = calibration[i].apply(current[i]);
+    averageCurrent[i] = calibration[i].apply(averageCurrent[i]);
+  }
+  for (size_t i = 0; i < voltageSense.size(); i++)
+  {
+    measured[3 + i] = voltageSense[i];
+    voltageSense[i] = calibration[3 + i].apply(voltageSense[i]);
+  }
+  uncalibrated.publish(measured);
+
+  //power use load voltage interpolated into the current block time, not the latest voltage
+  frameAligner.addVoltage(voltageSense, voltageSet.timestamp, voltageSequence);
+  PowerSense::power_frame_t powerFrame;
+  bool isAligned = frameAligner.align(current, currentTime, powerFrame);
+
+  //stalled acquisition never feed stale value into protection, every load is disconnected until sample is fresh again
+  systemStatus.flag.voltageFault = adsSampler.isStale(VOLTAGE_STALE_TIMEOUT);
+  systemStatus.flag.currentFault = currentSampler.isStale(CURRENT_STALE_TIMEOUT);
+  for (size_t i = 0; i < 3; i++)
+  {
+    loadHandle[i].setSensorFault(systemStatus.flag.voltageFault || systemStatus.flag.currentFault);
+  }
+
+  if (isAligned && currentSequence != lastCurrentSequence) //feed statistic and energy once per current block
+  {
+    lastCurrentSequence = currentSequence;
+    std::array<int16_t, STAT_CHANNEL> statValue;
+    std::array<int16_t, STAT_CHANNEL> statMin;
+    std::array<int16_t, STAT_CHANNEL> statMax;
+    for (size_t i = 0; i < 3; i++)
+    {
+      statValue[i] = current[i];
+      statMin[i] = calibration[i].apply(currentScale[i].convert(currentBlock.min[i])); //peak inside the block
+      statMax[i] = calibration[i].apply(currentScale[i].convert(currentBlock.max[i]));
+      statValue[3 + i] = powerFrame.voltage[2 - i]; //load 1 voltage is ADS channel 2
+      statValue[7 + i] = powerFrame.power[i];
+    }
+    statValue[6] = powerFrame.voltage[3];
+    for (size_t i = 3; i < STAT_CHANNEL; i++)
+    {
+      statMin[i] = statValue[i];
+      statMax[i] = statValue[i];
+    }
+    if (windowStats.update(statValue, statMin, statMax, millis()))
+    {
+      statSnapshot.publish(windowStats.getSnapshot());
+    }
+    for (size_t i = 0; i < 3; i++)
+    {
+      //open relay mean 0 A, learned offset is applied as soon as it move by 1 mV, fine value is not truncated into whole mV
+      if (!systemStatus.flag.currentFault && zeroTracker[i].update(currentBlock.fine[i], !relayConnected[i], CS_FINE_BITS) && zeroTracker[i].getOffset() != cc6940[i].getCurrentConfig().offset)
+      {
+        CC6940Config config = cc6940[i].getCurrentConfig();
+        config.offset = zeroTracker[i].getOffset();
+        cc6940[i].setup(config);
+        currentScale[i] = FixedScale::fromCC6940(config);
+        fineScale[i] = FixedScale::fromCC6940(config, CS_FINE_BITS);
+      }
+    }
+    if (!systemStatus.flag.voltageFault && !systemStatus.flag.currentFault) //stale sample is never integrated
+    {
+      energyMeter.update(current, powerFrame.power, powerFrame.timestamp, powerFrame.voltage[3]);
+      energyTotal.publish(energyMeter.getTotal());
+    }
   }
 
   for (size_t i = 0; i < 6; i++)
@@ -896,9 +1343,9 @@ void loop() {
     // ESP_LOGI(TAG, "Voltage on register modbus %d = %d", i, voltageSense[i]);
   // }
 
-  loadHandle[0].loop(voltageSense[3], current[0]); //loop the loadhandle object
-  loadHandle[1].loop(voltageSense[3], current[1]);
-  loadHandle[2].loop(voltageSense[3], current[2]);
+  loadHandle[0].loop(voltageSense[3], current[0], powerFrame.power[0]); //loop the loadhandle object
+  loadHandle[1].loop(voltageSense[3], current[1], powerFrame.power[1]);
+  loadHandle[2].loop(voltageSense[3], current[2], powerFrame.power[2]);
   latchHandle[0].handle(loadHandle[0].getAction(), relayConnected[0]); //handle the latchhandle object
   latchHandle[1].handle(loadHandle[1].getAction(), relayConnected[1]);
   latchHandle[2].handle(loadHandle[2].getAction(), relayConnected[2]);
@@ -920,6 +1367,17 @@ void loop() {
   // ESP_LOGI(TAG, "undervoltage flag : %d\n", loadHandle[0].isUndervoltage());
   // ESP_LOGI(TAG, "overcurrent flag : %d\n", loadHandle[0].isOvercurrent());
 
+  if (myCoils[10] || myCoils[11]) //check for shed all and reconnect all coil, switch into manual and pulse every channel
+  {
+    myCoils.set(6, true);
+    for (size_t i = 0; i < 3; i++)
+    {
+      relayCommand.push(i * 2 + (myCoils[10] ? 1 : 0)); //relay OFF for shed, relay ON for reconnect
+    }
+    myCoils.set(10, false);
+    myCoils.set(11, false);
+  }
+
   if (myCoils[6]) //check for manual coil
   {
     // ESP_LOGI(TAG, "manual");
@@ -927,15 +1385,6 @@ void loop() {
     {
       latchHandle[i].setManual();
     }
-    
-    for (size_t i = 0; i < 6; i++)
-    {
-      if (myCoils[i])
-      {
-        relay[i].set();
-        myCoils.set(i, false);
-      }
-    }
     systemStatus.flag.mode = 1;
   }
   else
@@ -973,15 +1422,42 @@ void loop() {
   buffRegs.assignLoadVoltage1(voltageSense[2]);
   buffRegs.assignLoadVoltage2(voltageSense[1]);
   buffRegs.assignLoadVoltage3(voltageSense[0]);
-  buffRegs.assignLoadCurrent1(current[0]);
-  buffRegs.assignLoadCurrent2(current[1]);
-  buffRegs.assignLoadCurrent3(current[2]);
+  buffRegs.assignLoadCurrent1(averageCurrent[0]);
+  buffRegs.assignLoadCurrent2(averageCurrent[1]);
+  buffRegs.assignLoadCurrent3(averageCurrent[2]);
+  for (size_t i = 0; i < 3; i++)
+  {
+    buffRegs.assignLoadPower(i, powerFrame.power[i]);
+  }
   buffRegs.assignFlag1(loadHandle[0].getStatus());
   buffRegs.assignFlag2(loadHandle[1].getStatus());
   buffRegs.assignFlag3(loadHandle[2].getStatus());
   buffRegs.assignFeedbackStatus(feedbackStatus.value);
   buffRegs.assignSystemStatus(systemStatus.value);
 
+  uint16_t coilStatus = 0;
+  for (size_t i = 0; i < myCoils.coils() && i < 16; i++)
+  {
+    coilStatus |= myCoils[i] << i;
+  }
+  buffRegs.assignCoilStatus(coilStatus);
+  buffRegs.assignUptime(millis() / 1000);
+  for (size_t i = 0; i < 3; i++)
+  {
+    buffRegs.assignRelayFailCount(i, latchHandle[i].getFailOnCount(), latchHandle[i].getFailOffCount());
+  }
+  telemetry.publish(buffRegs); //publish all register at once, never block the loop
+  if (changeTracker.update(buffRegs.extendedRegister))
+  {
+    changeState.publish(changeTracker.getState());
+  }
+
+  if (myCoils[9]) //check for diagnostic reset coil
+  {
+    myCoils.set(9, false);
+    mbHandler.resetStatistic();
+  }
+
   if (myCoils[8]) //check for factory reset coil
   {
     ESP_LOGI(TAG, "factory reset");
@@ -989,10 +1465,37 @@ void loop() {
     lp.reset();
   }
   
+  if (millis() - lastZeroSave > ZERO_SAVE_INTERVAL) //only changed offset is queued
+  {
+    lastZeroSave = millis();
+    bool isChanged = false;
+    for (size_t i = 0; i < 3; i++)
+    {
+      if (zeroTracker[i].getAccepted() && savedZeroOffset[i] != zeroTracker[i].getOffset())
+      {
+        savedZeroOffset[i] = zeroTracker[i].getOffset();
+        isChanged = true;
+      }
+    }
+    if (isChanged)
+    {
+      xQueueOverwrite(zeroSaveQueue, &savedZeroOffset); //written by zero save task
+    }
+  }
+
+  if (myCoils[12]) //check for energy reset coil
+  {
+    myCoils.set(12, false);
+    energyMeter.reset(); //every channel is reset and saved together
+    energyTotal.publish(energyMeter.getTotal());
+  }
+
   if (myCoils[7]) //check for restart coil
   {
     ESP_LOGI(TAG, "restart");
     myCoils.set(7, false);
+    energyMeter.flush();
+    delay(100); //give save task time to write energy total
     ESP.restart();
   }
   delay(1); //delay to give another task chance to execute
@@ -0,0 +1,58 @@
+/**
+ * Talis5 gateway program
+ *
+ * Modbus TCP to RTU gateway for every slave in the stored slave list, RS485 baudrate and tcp port
+ * are taken from Talis5Memory, network setting from EthernetSave
+ */
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <Ethernet.h>
+#include <EthernetSave.h>
+#include <Talis5Memory.h>
+#include <Talis5Gateway.h>
+#include <loaddefs.h>
+
+#include <ModbusClientRTU.h>
+
+#define LOG_LOCAL_LEVEL ESP_LOG_INFO
+#include "esp_log.h"
+
+#define GATEWAY_QUEUE_DEPTH 8
+
+const char* TAG = "talis5-gateway";
+
+Talis5Memory talis5Memory;
+
+EthernetSave ethernetSave;
+
+//RTU client queue is one slot deeper than the gateway so the gateway always answer busy first
+ModbusClientRTU MBclient(-1, GATEWAY_QUEUE_DEPTH + 1);
+
+Talis5Gateway gateway(MBclient);
+
+void setup() {
+  Serial.begin(115200);
+  talis5Memory.begin("talis5");
+  ethernetSave.begin("eth");
+
+  RTUutils::prepareHardwareSerial(Serial2);
+  Serial2.begin(talis5Memory.getBaudRate());
+  MBclient.setTimeout(1000);
+  MBclient.begin(Serial2);
+
+  //telemetry follow holding write (group command, overpower setpoint, calibration) so any register write drop it too
+  gateway.getCache().addRule(READ_INPUT_REGISTER, 0x1000, std::tuple_size<LoadModbus::inputRegisterArray>::value, 500); //load controller telemetry snapshot
+  gateway.getCache().addRule(READ_INPUT_REGISTER, 0x1100, LoadModbus::EXT_SIZE, 500); //load controller extended telemetry
+  gateway.getCache().addRule(READ_HOLD_REGISTER, 0x1000, 35, 5000); //load controller parameter, invalidated on write
+
+  Talis5::gateway_config_t config;
+  config.queueDepth = GATEWAY_QUEUE_DEPTH;
+  gateway.begin(ethernetSave, talis5Memory, config);
+}
+
+void loop() {
+  ESP_LOGI(TAG, "client %d, forwarded %d, busy %d\n", gateway.getActiveClient(), gateway.getForwardCount(), gateway.getBusyCount());
+  ESP_LOGI(TAG, "cache hit %d, miss %d, invalidate %d\n", gateway.getCache().getHit(), gateway.getCache().getMiss(), gateway.getCache().getInvalidate());
+  delay(5000);
+}
@@ -0,0 +1,53 @@
+/**
+ * Talis5 polling program
+ *
+ * Poll every load controller in the stored slave list over RS485, the telemetry snapshot and extended telemetry
+ * block are not contiguous so each slave is read with two request. achieved poll rate is printed every second
+ */
+
+#include <Arduino.h>
+#include <Talis5Memory.h>
+#include <Talis5Poller.h>
+#include <loaddefs.h>
+
+#include <ModbusClientRTU.h>
+
+#define LOG_LOCAL_LEVEL ESP_LOG_INFO
+#include "esp_log.h"
+
+const char* TAG = "talis5-poller";
+
+Talis5Memory talis5Memory;
+
+ModbusClientRTU MBclient;
+
+Talis5Poller poller(MBclient);
+
+void setup() {
+  Serial.begin(115200);
+  talis5Memory.begin("talis5");
+
+  RTUutils::prepareHardwareSerial(Serial2);
+  Serial2.begin(talis5Memory.getBaudRate());
+  MBclient.begin(Serial2);
+
+  poller.addRange(READ_INPUT_REGISTER, 0x1000, std::tuple_size<LoadModbus::inputRegisterArray>::value); //telemetry snapshot
+  poller.addRange(READ_INPUT_REGISTER, 0x1100, LoadModbus::EXT_SIZE); //extended telemetry
+  poller.begin(talis5Memory);
+}
+
+void loop() {
+  std::vector<uint8_t> slaveList(talis5Memory.getSlaveSize());
+  talis5Memory.getSlave(slaveList.data(), slaveList.size());
+  for (uint8_t id : slaveList)
+  {
+    Talis5::slave_state_t state;
+    uint16_t voltage = 0;
+    if (poller.getSlaveState(id, state) && state.isOnline && poller.getRegister(id, READ_INPUT_REGISTER, 0x1100, 1, &voltage))
+    {
+      ESP_LOGI(TAG, "slave %d : system voltage %d, timeout %d ms, error %d\n", id, voltage, state.timeout, state.error);
+    }
+  }
+  ESP_LOGI(TAG, "%d poll/s\n", poller.getPollRate());
+  delay(5000);
+}
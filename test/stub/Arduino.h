@@ -0,0 +1,37 @@
+#ifndef ARDUINO_STUB_H
+#define ARDUINO_STUB_H
+
+/**
+ * Minimal Arduino API for the native test env, time only move when the test advance Stub::now
+ */
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <esp_err.h>
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+
+namespace Stub {
+    inline uint64_t now = 0; //current time in us
+};
+
+inline unsigned long micros() { return (uint32_t)Stub::now; } //32 bit on ESP32, wrap after about 71 minutes
+inline unsigned long millis() { return (uint32_t)(Stub::now / 1000); }
+inline void delay(uint32_t ms) { Stub::now += (uint64_t)ms * 1000; }
+
+/**
+ * ESP32 analog channel of the pin, ADC1 channel is 0 - 7 and ADC2 channel is 10 - 19
+ */
+inline int8_t digitalPinToAnalogChannel(uint8_t pin)
+{
+    const int8_t channel[40] = {
+        11, -1, 12, -1, 10, -1, -1, -1, -1, -1, -1, -1, 15, 14, 16, 13, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, 18, 19, 17, -1, -1, -1, -1, 4, 5, 6, 7, 0, 1, 2, 3};
+    return pin < 40 ? channel[pin] : -1;
+}
+
+#endif
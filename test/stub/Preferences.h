@@ -0,0 +1,86 @@
+#ifndef PREFERENCES_STUB_H
+#define PREFERENCES_STUB_H
+
+/**
+ * Preferences stub for the native test env, every namespace is kept in memory for the whole test run
+ */
+#include <Arduino.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Stub {
+    inline std::map<std::string, std::map<std::string, std::vector<uint8_t>>> nvs; //namespace, key, value
+};
+
+class Preferences
+{
+private:
+    std::map<std::string, std::vector<uint8_t>> *_store = NULL;
+    bool _isReadOnly = false;
+
+    template <typename T>
+    size_t put(const char *key, T value)
+    {
+        return putBytes(key, &value, sizeof(value));
+    }
+
+    template <typename T>
+    T get(const char *key, T defaultValue)
+    {
+        T value = defaultValue;
+        return getBytesLength(key) == sizeof(T) && getBytes(key, &value, sizeof(T)) ? value : defaultValue;
+    }
+public:
+    bool begin(const char *name, bool readOnly = false)
+    {
+        _store = &Stub::nvs[name];
+        _isReadOnly = readOnly;
+        return true;
+    }
+    void end() { _store = NULL; }
+    bool clear()
+    {
+        _store->clear();
+        return true;
+    }
+    bool remove(const char *key) { return _store->erase(key) > 0; }
+    bool isKey(const char *key) { return _store->count(key) > 0; }
+
+    size_t putBytes(const char *key, const void *value, size_t len)
+    {
+        if (_store == NULL || _isReadOnly)
+        {
+            return 0;
+        }
+        const uint8_t *data = static_cast<const uint8_t*>(value);
+        (*_store)[key].assign(data, data + len);
+        return len;
+    }
+    size_t getBytesLength(const char *key)
+    {
+        auto it = _store->find(key);
+        return it == _store->end() ? 0 : it->second.size();
+    }
+    size_t getBytes(const char *key, void *buf, size_t maxLen)
+    {
+        size_t len = getBytesLength(key);
+        if (len == 0 || len > maxLen)
+        {
+            return 0;
+        }
+        memcpy(buf, (*_store)[key].data(), len);
+        return len;
+    }
+
+    size_t putBool(const char *key, bool value) { return put<uint8_t>(key, value); }
+    bool getBool(const char *key, bool defaultValue = false) { return get<uint8_t>(key, defaultValue); }
+    size_t putShort(const char *key, int16_t value) { return put(key, value); }
+    int16_t getShort(const char *key, int16_t defaultValue = 0) { return get(key, defaultValue); }
+    size_t putUShort(const char *key, uint16_t value) { return put(key, value); }
+    uint16_t getUShort(const char *key, uint16_t defaultValue = 0) { return get(key, defaultValue); }
+    size_t putUInt(const char *key, uint32_t value) { return put(key, value); }
+    uint32_t getUInt(const char *key, uint32_t defaultValue = 0) { return get(key, defaultValue); }
+};
+
+#endif
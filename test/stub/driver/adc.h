@@ -0,0 +1,60 @@
+#ifndef ADC_STUB_H
+#define ADC_STUB_H
+
+/**
+ * ADC continuous mode stub for the native test env, dma never return a frame so sample is fed by the test
+ */
+#include <stdint.h>
+#include <esp_err.h>
+
+#define SOC_ADC_DIGI_MAX_BITWIDTH 12
+#define ADC_MAX_DELAY UINT32_MAX
+
+typedef enum { ADC1_CHANNEL_0 = 0, ADC1_CHANNEL_MAX = 8 } adc1_channel_t;
+typedef enum { ADC_UNIT_1 = 1 } adc_unit_t;
+typedef enum { ADC_ATTEN_DB_11 = 3 } adc_atten_t;
+typedef enum { ADC_WIDTH_BIT_12 = 3 } adc_bits_width_t;
+typedef enum { ADC_CONV_SINGLE_UNIT_1 = 1 } adc_digi_convert_mode_t;
+typedef enum { ADC_DIGI_OUTPUT_FORMAT_TYPE1 = 0 } adc_digi_output_format_t;
+
+typedef struct {
+    uint8_t atten;
+    uint8_t channel;
+    uint8_t unit;
+    uint8_t bit_width;
+} adc_digi_pattern_config_t;
+
+typedef struct {
+    uint32_t max_store_buf_size;
+    uint32_t conv_num_each_intr;
+    uint32_t adc1_chan_mask;
+    uint32_t adc2_chan_mask;
+} adc_digi_init_config_t;
+
+typedef struct {
+    bool conv_limit_en;
+    uint32_t conv_limit_num;
+    uint32_t pattern_num;
+    adc_digi_pattern_config_t *adc_pattern;
+    uint32_t sample_freq_hz;
+    adc_digi_convert_mode_t conv_mode;
+    adc_digi_output_format_t format;
+} adc_digi_configuration_t;
+
+typedef struct {
+    union {
+        struct {
+            uint16_t data: 12;
+            uint16_t channel: 4;
+        } type1;
+        uint16_t val;
+    };
+} adc_digi_output_data_t;
+
+inline esp_err_t adc_digi_initialize(const adc_digi_init_config_t *) { return ESP_OK; }
+inline esp_err_t adc_digi_controller_configure(const adc_digi_configuration_t *) { return ESP_OK; }
+inline esp_err_t adc_digi_start() { return ESP_OK; }
+inline esp_err_t adc_digi_stop() { return ESP_OK; }
+inline esp_err_t adc_digi_read_bytes(uint8_t *, uint32_t, uint32_t *length, uint32_t) { *length = 0; return ESP_ERR_TIMEOUT; }
+
+#endif
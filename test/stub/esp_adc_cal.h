@@ -0,0 +1,23 @@
+#ifndef ESP_ADC_CAL_STUB_H
+#define ESP_ADC_CAL_STUB_H
+
+/**
+ * ADC calibration stub for the native test env, calibrated voltage is the raw value
+ */
+#include <driver/adc.h>
+
+typedef enum { ESP_ADC_CAL_VAL_EFUSE_VREF = 0, ESP_ADC_CAL_VAL_EFUSE_TP = 1, ESP_ADC_CAL_VAL_DEFAULT_VREF = 2 } esp_adc_cal_value_t;
+
+typedef struct {
+    uint32_t vref;
+} esp_adc_cal_characteristics_t;
+
+inline esp_adc_cal_value_t esp_adc_cal_characterize(adc_unit_t, adc_atten_t, adc_bits_width_t, uint32_t vref, esp_adc_cal_characteristics_t *characteristic)
+{
+    characteristic->vref = vref;
+    return ESP_ADC_CAL_VAL_DEFAULT_VREF;
+}
+
+inline uint32_t esp_adc_cal_raw_to_voltage(uint32_t raw, const esp_adc_cal_characteristics_t *) { return raw; }
+
+#endif
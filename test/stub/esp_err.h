@@ -0,0 +1,11 @@
+#ifndef ESP_ERR_STUB_H
+#define ESP_ERR_STUB_H
+
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_INVALID_STATE 0x103
+#define ESP_ERR_TIMEOUT 0x107
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef ESP_LOG_STUB_H
+#define ESP_LOG_STUB_H
+
+/**
+ * Log is discarded in the native test env, argument is still evaluated like on the target
+ */
+template <typename... Args>
+inline void espLogStub(const char *, const char *, Args &&...)
+{
+}
+
+#define ESP_LOGE(tag, format, ...) espLogStub(tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) espLogStub(tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) espLogStub(tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) espLogStub(tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) espLogStub(tag, format, ##__VA_ARGS__)
+
+#endif
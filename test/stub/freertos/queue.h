@@ -0,0 +1,59 @@
+#ifndef FREERTOS_QUEUE_STUB_H
+#define FREERTOS_QUEUE_STUB_H
+
+/**
+ * FreeRTOS queue stub for the native test env, single slot queue is enough for the overwrite mailbox pattern.
+ * Stub::queueSend count every item sent so the test can see a flush without running the receiving task
+ */
+#include <string.h>
+#include <vector>
+#include "FreeRTOS.h"
+
+struct QueueStub {
+    std::vector<uint8_t> item;
+    bool isFull = false;
+};
+typedef QueueStub *QueueHandle_t;
+
+namespace Stub {
+    inline uint32_t queueSend = 0; //number of item sent into any queue
+};
+
+inline QueueHandle_t xQueueCreate(UBaseType_t, UBaseType_t itemSize)
+{
+    QueueHandle_t queue = new QueueStub();
+    queue->item.resize(itemSize);
+    return queue;
+}
+
+inline BaseType_t xQueueOverwrite(QueueHandle_t queue, const void *item)
+{
+    memcpy(queue->item.data(), item, queue->item.size());
+    queue->isFull = true;
+    Stub::queueSend++;
+    return pdPASS;
+}
+
+inline BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t)
+{
+    if (queue->isFull)
+    {
+        return pdFALSE;
+    }
+    return xQueueOverwrite(queue, item);
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t)
+{
+    if (!queue->isFull)
+    {
+        return pdFALSE;
+    }
+    memcpy(item, queue->item.data(), queue->item.size());
+    queue->isFull = false;
+    return pdTRUE;
+}
+
+inline void vQueueDelete(QueueHandle_t queue) { delete queue; }
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef FREERTOS_SEMPHR_STUB_H
+#define FREERTOS_SEMPHR_STUB_H
+
+/**
+ * FreeRTOS mutex stub for the native test env, backed by std::recursive_mutex
+ */
+#include <mutex>
+#include "FreeRTOS.h"
+
+typedef std::recursive_mutex *SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { return new std::recursive_mutex(); }
+inline SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() { return new std::recursive_mutex(); }
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t) { mutex->lock(); return pdTRUE; }
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex) { mutex->unlock(); return pdTRUE; }
+inline BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t mutex, TickType_t) { mutex->lock(); return pdTRUE; }
+inline BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t mutex) { mutex->unlock(); return pdTRUE; }
+inline void vSemaphoreDelete(SemaphoreHandle_t mutex) { delete mutex; }
+
+#endif
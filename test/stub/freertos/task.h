@@ -0,0 +1,6 @@
+#ifndef FREERTOS_TASK_STUB_H
+#define FREERTOS_TASK_STUB_H
+
+#include "FreeRTOS.h"
+
+#endif
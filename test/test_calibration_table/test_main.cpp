@@ -0,0 +1,132 @@
+#include <unity.h>
+#include <CalibrationTable.h>
+
+static CalibrationTable table;
+
+void setUp()
+{
+    table.clear();
+    Stub::nvs.clear();
+}
+
+void tearDown()
+{
+}
+
+void test_empty_table_return_value()
+{
+    TEST_ASSERT_EQUAL_INT16(1234, table.apply(1234));
+    TEST_ASSERT_EQUAL_INT16(-5, table.apply(-5));
+}
+
+void test_single_point_shift_value()
+{
+    table.insert(1000, 1020);
+    TEST_ASSERT_EQUAL_INT16(20, table.apply(0));
+    TEST_ASSERT_EQUAL_INT16(1020, table.apply(1000));
+    TEST_ASSERT_EQUAL_INT16(INT16_MAX, table.apply(INT16_MAX - 10)); //saturated
+}
+
+void test_multi_point_interpolate_and_extrapolate()
+{
+    table.insert(200, 200);
+    table.insert(0, 0);
+    table.insert(100, 110); //inserted out of order
+    TEST_ASSERT_EQUAL_UINT8(3, table.getSize());
+    TEST_ASSERT_EQUAL_INT16(0, table.apply(0));
+    TEST_ASSERT_EQUAL_INT16(110, table.apply(100));
+    TEST_ASSERT_EQUAL_INT16(200, table.apply(200));
+    TEST_ASSERT_EQUAL_INT16(55, table.apply(50));
+    TEST_ASSERT_EQUAL_INT16(155, table.apply(150));
+    TEST_ASSERT_EQUAL_INT16(-110, table.apply(-100)); //first segment extended
+    TEST_ASSERT_EQUAL_INT16(290, table.apply(300)); //last segment extended
+    TEST_ASSERT_EQUAL_INT16(INT16_MIN, table.apply(-32000)); //saturated
+}
+
+void test_insert_replace_same_measured()
+{
+    table.insert(0, 0);
+    table.insert(100, 110);
+    TEST_ASSERT_TRUE(table.insert(100, 120));
+    TEST_ASSERT_EQUAL_UINT8(2, table.getSize());
+    TEST_ASSERT_EQUAL_INT16(60, table.apply(50));
+}
+
+void test_insert_into_full_table()
+{
+    for (int16_t i = 0; i < CT_MAX_POINT; i++)
+    {
+        TEST_ASSERT_TRUE(table.insert(i * 10, i * 10));
+    }
+    TEST_ASSERT_FALSE(table.insert(-10, -10));
+    TEST_ASSERT_TRUE(table.insert(0, 1)); //replace is still allowed
+    TEST_ASSERT_EQUAL_UINT8(CT_MAX_POINT, table.getSize());
+}
+
+void test_unsorted_write_is_rejected_atomically()
+{
+    table.insert(0, 0);
+    table.insert(100, 110);
+    uint16_t before[CT_REGISTER_SIZE];
+    table.readRegister(0, CT_REGISTER_SIZE, before);
+
+    const uint16_t unsorted[] = {3, 0, 0, 200, 200, 100, 100};
+    TEST_ASSERT_FALSE(table.writeRegister(0, 7, unsorted));
+    const uint16_t duplicate[] = {0, 0}; //second point measured equal to the first
+    TEST_ASSERT_FALSE(table.writeRegister(3, 2, duplicate));
+
+    uint16_t after[CT_REGISTER_SIZE];
+    table.readRegister(0, CT_REGISTER_SIZE, after);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(before, after, CT_REGISTER_SIZE);
+    TEST_ASSERT_EQUAL_INT16(55, table.apply(50));
+}
+
+void test_write_register_range()
+{
+    const uint16_t tooMany[] = {CT_MAX_POINT + 1};
+    TEST_ASSERT_FALSE(table.writeRegister(0, 1, tooMany));
+    uint16_t buff[2] = {};
+    TEST_ASSERT_FALSE(table.writeRegister(CT_REGISTER_SIZE - 1, 2, buff));
+    TEST_ASSERT_FALSE(table.readRegister(CT_REGISTER_SIZE - 1, 2, buff));
+    TEST_ASSERT_EQUAL_UINT8(0, table.getSize());
+
+    const uint16_t points[] = {2, (uint16_t)-100, (uint16_t)-90, 100, 90}; //signed register
+    TEST_ASSERT_TRUE(table.writeRegister(0, 5, points));
+    TEST_ASSERT_EQUAL_INT16(0, table.apply(0));
+    TEST_ASSERT_EQUAL_INT16(-90, table.apply(-100));
+}
+
+void test_save_and_load()
+{
+    table.insert(0, 5);
+    table.insert(1000, 1010);
+    Preferences preferences;
+    preferences.begin("calib");
+    table.save(preferences, "ch0");
+
+    CalibrationTable restored;
+    TEST_ASSERT_TRUE(restored.load(preferences, "ch0"));
+    TEST_ASSERT_EQUAL_UINT8(2, restored.getSize());
+    TEST_ASSERT_EQUAL_INT16(table.apply(500), restored.apply(500));
+    TEST_ASSERT_FALSE(restored.load(preferences, "ch1")); //nothing stored
+
+    uint16_t regs[CT_REGISTER_SIZE] = {2, 100, 0, 50, 0}; //stored table is not sorted
+    preferences.putBytes("ch2", regs, sizeof(regs));
+    TEST_ASSERT_FALSE(restored.load(preferences, "ch2"));
+    TEST_ASSERT_EQUAL_UINT8(2, restored.getSize());
+    preferences.end();
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_table_return_value);
+    RUN_TEST(test_single_point_shift_value);
+    RUN_TEST(test_multi_point_interpolate_and_extrapolate);
+    RUN_TEST(test_insert_replace_same_measured);
+    RUN_TEST(test_insert_into_full_table);
+    RUN_TEST(test_unsorted_write_is_rejected_atomically);
+    RUN_TEST(test_write_register_range);
+    RUN_TEST(test_save_and_load);
+    return UNITY_END();
+}
@@ -0,0 +1,85 @@
+#include <unity.h>
+#include <ChangeTracker.h>
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_first_update_report_everything()
+{
+    ChangeTracker<4> tracker;
+    uint16_t bitmap = 0;
+    TEST_ASSERT_TRUE(tracker.update({0, 0, 0, 0}));
+    tracker.getState().getBitmap(0, &bitmap, 1);
+    TEST_ASSERT_EQUAL_HEX16(0x000F, bitmap);
+}
+
+void test_change_equal_to_deadband_is_reported()
+{
+    ChangeTracker<2> tracker;
+    tracker.setDeadband(0, 2); //0.2 V on 0.1 V register
+    tracker.update({500, 0});
+    TEST_ASSERT_FALSE(tracker.update({501, 0}));
+    TEST_ASSERT_TRUE(tracker.update({502, 0})); //exactly the deadband
+    TEST_ASSERT_FALSE(tracker.update({501, 0})); //compared with the last reported value
+    TEST_ASSERT_TRUE(tracker.update({500, 0}));
+    TEST_ASSERT_EQUAL_UINT16(3, tracker.getSequence());
+}
+
+void test_signed_register_cross_zero()
+{
+    ChangeTracker<1> tracker;
+    tracker.setDeadband(0, 5);
+    tracker.update({(uint16_t)2});
+    TEST_ASSERT_FALSE(tracker.update({(uint16_t)-2}));
+    TEST_ASSERT_TRUE(tracker.update({(uint16_t)-3}));
+}
+
+void test_zero_deadband_report_every_change_only()
+{
+    ChangeTracker<1> tracker;
+    tracker.update({7});
+    TEST_ASSERT_FALSE(tracker.update({7}));
+    TEST_ASSERT_TRUE(tracker.update({8}));
+}
+
+void test_disabled_register_is_never_reported()
+{
+    ChangeTracker<2> tracker;
+    tracker.setDeadband(0, 2, 0xFFFF);
+    tracker.update({0, 0});
+    TEST_ASSERT_FALSE(tracker.update({1000, 0xFFFF}));
+}
+
+void test_bitmap_since_sequence()
+{
+    ChangeTracker<20> tracker;
+    std::array<uint16_t, 20> value = {};
+    tracker.update(value);
+    uint16_t since = tracker.getSequence();
+    value[1] = 10;
+    value[17] = 10;
+    tracker.update(value);
+    uint16_t bitmap[2] = {};
+    TEST_ASSERT_EQUAL_size_t(2, tracker.getState().getBitmap(since, bitmap, 2));
+    TEST_ASSERT_EQUAL_HEX16(0x0002, bitmap[0]);
+    TEST_ASSERT_EQUAL_HEX16(0x0002, bitmap[1]);
+    tracker.getState().getBitmap(tracker.getSequence(), bitmap, 2);
+    TEST_ASSERT_EQUAL_HEX16(0, bitmap[0] | bitmap[1]);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_first_update_report_everything);
+    RUN_TEST(test_change_equal_to_deadband_is_reported);
+    RUN_TEST(test_signed_register_cross_zero);
+    RUN_TEST(test_zero_deadband_report_every_change_only);
+    RUN_TEST(test_disabled_register_is_never_reported);
+    RUN_TEST(test_bitmap_since_sequence);
+    return UNITY_END();
+}
@@ -0,0 +1,305 @@
+#include <unity.h>
+#include <CurrentSampler.h>
+#include <random>
+
+void setUp()
+{
+    Stub::now = 1000000;
+}
+
+void tearDown()
+{
+}
+
+/**
+ * Feed single block where every channel has the same sample sequence plus its channel offset
+ *
+ * @param[in]   sampler sampler under test
+ * @param[in]   sample  sample sequence, CS_BLOCK_SIZE sample
+ * @param[in]   offset  added to the sample for each channel index
+ */
+static void feedBlock(CurrentSampler &sampler, const uint16_t *sample, uint16_t offset)
+{
+    for (size_t n = 0; n < CS_BLOCK_SIZE; n++)
+    {
+        for (size_t ch = 0; ch < CS_CHANNEL; ch++)
+        {
+            sampler.feed(ch, sample[n] + ch * offset);
+        }
+    }
+}
+
+void test_block_is_published_when_every_channel_is_full()
+{
+    CurrentSampler sampler;
+    CurrentSense::sample_block_t block;
+    for (size_t n = 0; n < CS_BLOCK_SIZE; n++)
+    {
+        sampler.feed(0, 1000);
+        sampler.feed(1, 1000);
+    }
+    for (size_t n = 0; n < CS_BLOCK_SIZE - 1; n++)
+    {
+        sampler.feed(2, 1000);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, sampler.read(block));
+    sampler.feed(2, 1000);
+    TEST_ASSERT_EQUAL_UINT32(1, sampler.read(block));
+}
+
+void test_invalid_channel_is_ignored()
+{
+    CurrentSampler sampler;
+    CurrentSense::sample_block_t block;
+    for (size_t n = 0; n < CS_BLOCK_SIZE * 2; n++)
+    {
+        sampler.feed(CS_CHANNEL, 1000);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, sampler.read(block));
+}
+
+void test_block_statistic()
+{
+    CurrentSampler sampler;
+    uint16_t sample[CS_BLOCK_SIZE];
+    for (size_t n = 0; n < CS_BLOCK_SIZE; n++)
+    {
+        sample[n] = 1600 + n % 4; //mean 1601.5
+    }
+    sample[10] = 1500;
+    sample[20] = 1700;
+    feedBlock(sampler, sample, 100);
+
+    CurrentSense::sample_block_t block;
+    TEST_ASSERT_EQUAL_UINT32(1, sampler.read(block));
+    for (size_t ch = 0; ch < CS_CHANNEL; ch++)
+    {
+        uint32_t sum = 0;
+        for (size_t n = 0; n < CS_BLOCK_SIZE; n++)
+        {
+            sum += sample[n] + ch * 100;
+        }
+        TEST_ASSERT_EQUAL_UINT32(sum / CS_BLOCK_SIZE, block.mean[ch]);
+        TEST_ASSERT_EQUAL_UINT32(1500 + ch * 100, block.min[ch]);
+        TEST_ASSERT_EQUAL_UINT32(1700 + ch * 100, block.max[ch]);
+        TEST_ASSERT_EQUAL_UINT32((((uint64_t)sum << CS_FINE_BITS) + CS_BLOCK_SIZE / 2) / CS_BLOCK_SIZE, block.fine[ch]);
+    }
+}
+
+void test_accumulator_is_reset_between_block()
+{
+    CurrentSampler sampler;
+    uint16_t low[CS_BLOCK_SIZE];
+    uint16_t high[CS_BLOCK_SIZE];
+    for (size_t n = 0; n < CS_BLOCK_SIZE; n++)
+    {
+        low[n] = 500;
+        high[n] = 2500;
+    }
+    feedBlock(sampler, low, 0);
+    feedBlock(sampler, high, 0);
+
+    CurrentSense::sample_block_t block;
+    TEST_ASSERT_EQUAL_UINT32(2, sampler.read(block));
+    TEST_ASSERT_EQUAL_UINT32(2500, block.mean[0]);
+    TEST_ASSERT_EQUAL_UINT32(2500, block.min[0]); //min of the previous block is not carried
+    TEST_ASSERT_EQUAL_UINT32(2500, block.max[0]);
+    TEST_ASSERT_EQUAL_UINT32(2500 << CS_FINE_BITS, block.fine[0]);
+}
+
+void test_timestamp_is_block_center()
+{
+    CurrentSampler sampler;
+    uint16_t sample[CS_BLOCK_SIZE] = {};
+    feedBlock(sampler, sample, 0);
+
+    CurrentSense::sample_block_t block;
+    uint32_t timestamp = 0;
+    TEST_ASSERT_EQUAL_UINT32(1, sampler.read(block, timestamp));
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)Stub::now - CS_BLOCK_PERIOD / 2, timestamp);
+}
+
+void test_stale_detection()
+{
+    CurrentSampler sampler;
+    TEST_ASSERT_TRUE(sampler.isStale(CS_BLOCK_PERIOD * 4)); //nothing is posted
+
+    uint16_t sample[CS_BLOCK_SIZE] = {};
+    feedBlock(sampler, sample, 0);
+    TEST_ASSERT_FALSE(sampler.isStale(CS_BLOCK_PERIOD * 4));
+    Stub::now += CS_BLOCK_PERIOD * 4;
+    TEST_ASSERT_TRUE(sampler.isStale(CS_BLOCK_PERIOD * 4));
+}
+
+void test_begin_reject_non_adc1_pin()
+{
+    CurrentSampler sampler;
+    TEST_ASSERT_FALSE(sampler.begin({36, 39, 25})); //GPIO25 is ADC2
+    TEST_ASSERT_TRUE(sampler.begin({36, 39, 34}));
+}
+
+/**
+ * Feed single block of constant value into every channel
+ *
+ * @param[in]   sampler sampler under test
+ * @param[in]   value   raw value
+ */
+static void feedConstant(CurrentSampler &sampler, uint16_t value)
+{
+    for (size_t n = 0; n < CS_BLOCK_SIZE; n++)
+    {
+        for (size_t ch = 0; ch < CS_CHANNEL; ch++)
+        {
+            sampler.feed(ch, value);
+        }
+    }
+}
+
+void test_oversampling_is_clamped()
+{
+    CurrentSampler sampler;
+    TEST_ASSERT_EQUAL_UINT8(1, sampler.getOversampling(0));
+    sampler.setOversampling(0, 0);
+    sampler.setOversampling(1, CS_MAX_OVERSAMPLE + 1);
+    sampler.setOversampling(2, 4);
+    sampler.setOversampling(CS_CHANNEL, 4);
+    TEST_ASSERT_EQUAL_UINT8(1, sampler.getOversampling(0));
+    TEST_ASSERT_EQUAL_UINT8(CS_MAX_OVERSAMPLE, sampler.getOversampling(1));
+    TEST_ASSERT_EQUAL_UINT8(4, sampler.getOversampling(2));
+    TEST_ASSERT_EQUAL_UINT8(0, sampler.getOversampling(CS_CHANNEL));
+}
+
+void test_extra_bits_follow_averaged_sample()
+{
+    CurrentSampler sampler;
+    sampler.setOversampling(1, 4);
+    sampler.setOversampling(2, 16);
+    CurrentSense::sample_block_t block;
+    for (size_t n = 0; n < 16; n++)
+    {
+        feedConstant(sampler, 1000);
+    }
+    sampler.read(block);
+    TEST_ASSERT_EQUAL_UINT8(3, block.extraBits[0]); //64 sample
+    TEST_ASSERT_EQUAL_UINT8(4, block.extraBits[1]); //256 sample
+    TEST_ASSERT_EQUAL_UINT8(5, block.extraBits[2]); //1024 sample, limited by CS_FINE_BITS
+}
+
+void test_history_restart_on_change()
+{
+    CurrentSampler sampler;
+    CurrentSense::sample_block_t block;
+    for (size_t n = 0; n < 4; n++)
+    {
+        feedConstant(sampler, 1000);
+    }
+    sampler.setOversampling(0, 4);
+    feedConstant(sampler, 2000);
+    sampler.read(block);
+    TEST_ASSERT_EQUAL_UINT32(2000 << CS_FINE_BITS, block.oversampled[0]); //block averaged with N = 1 is dropped
+    TEST_ASSERT_EQUAL_UINT8(3, block.extraBits[0]);
+    for (size_t n = 0; n < 3; n++)
+    {
+        feedConstant(sampler, 2000);
+    }
+    sampler.read(block);
+    TEST_ASSERT_EQUAL_UINT8(4, block.extraBits[0]);
+}
+
+void test_fine_value_has_no_latency()
+{
+    CurrentSampler sampler;
+    sampler.setOversampling(0, 4);
+    CurrentSense::sample_block_t block;
+    for (size_t n = 0; n < 4; n++)
+    {
+        feedConstant(sampler, 1000);
+    }
+    feedConstant(sampler, 2000);
+    sampler.read(block);
+    TEST_ASSERT_EQUAL_UINT32(2000 << CS_FINE_BITS, block.fine[0]);
+    TEST_ASSERT_EQUAL_UINT32(1250 << CS_FINE_BITS, block.oversampled[0]);
+    TEST_ASSERT_EQUAL_UINT32(2000 << CS_FINE_BITS, block.oversampled[1]); //N = 1 follow the latest block
+}
+
+/**
+ * Measure rms error of fine and oversampled value of channel 0 for a dithered constant input
+ *
+ * @param[in]   value   true input in raw unit
+ * @param[in]   noise   standard deviation of the input noise in raw unit
+ * @param[in]   oversample  number of averaged block
+ * @param[out]  fineError   rms error of fine value in raw unit
+ * @param[out]  oversampledError    rms error of oversampled value in raw unit
+ */
+static void measureError(double value, double noise, uint8_t oversample, double &fineError, double &oversampledError)
+{
+    CurrentSampler sampler;
+    sampler.setOversampling(0, oversample);
+    std::mt19937 generator(42);
+    std::normal_distribution<double> distribution(0, noise > 0 ? noise : 1);
+    CurrentSense::sample_block_t block;
+    double fineSquare = 0;
+    double oversampledSquare = 0;
+    const size_t warmup = CS_MAX_OVERSAMPLE;
+    const size_t measured = 256;
+    for (size_t b = 0; b < warmup + measured; b++)
+    {
+        for (size_t n = 0; n < CS_BLOCK_SIZE; n++)
+        {
+            double input = value + (noise > 0 ? distribution(generator) : 0);
+            for (size_t ch = 0; ch < CS_CHANNEL; ch++)
+            {
+                sampler.feed(ch, (uint16_t)lround(input));
+            }
+        }
+        if (b < warmup)
+        {
+            continue;
+        }
+        sampler.read(block);
+        double fine = (double)block.fine[0] / (1 << CS_FINE_BITS) - value;
+        double oversampled = (double)block.oversampled[0] / (1 << CS_FINE_BITS) - value;
+        fineSquare += fine * fine;
+        oversampledSquare += oversampled * oversampled;
+    }
+    fineError = sqrt(fineSquare / measured);
+    oversampledError = sqrt(oversampledSquare / measured);
+}
+
+void test_effective_resolution_with_dither()
+{
+    double fineError = 0;
+    double oversampledError = 0;
+    measureError(1234.37, 0.7, CS_MAX_OVERSAMPLE, fineError, oversampledError);
+    TEST_ASSERT_LESS_THAN(0.15, fineError); //64 sample, about 3 bit below 1 LSB
+    TEST_ASSERT_LESS_THAN(0.04, oversampledError); //1024 sample, about 5 bit below 1 LSB
+    TEST_ASSERT_GREATER_THAN(2.5, fineError / oversampledError); //ideal gain is sqrt(16)
+}
+
+void test_no_resolution_gain_without_dither()
+{
+    double fineError = 0;
+    double oversampledError = 0;
+    measureError(1234.37, 0, CS_MAX_OVERSAMPLE, fineError, oversampledError);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 0.37, fineError); //every sample is quantized into 1234
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 0.37, oversampledError);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_block_is_published_when_every_channel_is_full);
+    RUN_TEST(test_invalid_channel_is_ignored);
+    RUN_TEST(test_block_statistic);
+    RUN_TEST(test_accumulator_is_reset_between_block);
+    RUN_TEST(test_timestamp_is_block_center);
+    RUN_TEST(test_stale_detection);
+    RUN_TEST(test_begin_reject_non_adc1_pin);
+    RUN_TEST(test_oversampling_is_clamped);
+    RUN_TEST(test_extra_bits_follow_averaged_sample);
+    RUN_TEST(test_history_restart_on_change);
+    RUN_TEST(test_fine_value_has_no_latency);
+    RUN_TEST(test_effective_resolution_with_dither);
+    RUN_TEST(test_no_resolution_gain_without_dither);
+    return UNITY_END();
+}
@@ -0,0 +1,145 @@
+#include <unity.h>
+#include <EnergyMeter.h>
+
+static const std::array<int16_t, EM_CHANNEL> current = {100, 200, -100}; //1 A, 2 A, -1 A
+static const std::array<int16_t, EM_CHANNEL> power = {500, 1000, -500}; //50 W, 100 W, -50 W
+
+void setUp()
+{
+    Stub::now = 100000000; //100 s
+    Stub::nvs.clear();
+}
+
+void tearDown()
+{
+}
+
+void test_integrate_step()
+{
+    EnergyMeter meter;
+    meter.begin("energy", 60000);
+    meter.update(current, power, 1000, 240);
+    TEST_ASSERT_TRUE(meter.getTotal().charge[0] == 0); //first frame only set the timestamp
+    meter.update(current, power, 1000 + EM_MAX_STEP, 240);
+    TEST_ASSERT_TRUE(meter.getTotal().charge[0] == 100LL * EM_MAX_STEP);
+    TEST_ASSERT_TRUE(meter.getTotal().energy[1] == 1000LL * EM_MAX_STEP);
+    TEST_ASSERT_TRUE(meter.getTotal().energy[2] == -500LL * EM_MAX_STEP);
+}
+
+void test_step_above_max_is_skipped()
+{
+    EnergyMeter meter;
+    meter.begin("energy", 60000);
+    meter.update(current, power, 0, 240);
+    meter.update(current, power, EM_MAX_STEP + 1, 240); //stalled sampling
+    TEST_ASSERT_TRUE(meter.getTotal().charge[0] == 0);
+    meter.update(current, power, EM_MAX_STEP + 1001, 240); //integrate again from the last frame
+    TEST_ASSERT_TRUE(meter.getTotal().charge[0] == 100LL * 1000);
+}
+
+void test_step_across_timer_wrap()
+{
+    EnergyMeter meter;
+    meter.begin("energy", 60000);
+    meter.update(current, power, UINT32_MAX - 499, 240);
+    meter.update(current, power, 500, 240);
+    TEST_ASSERT_TRUE(meter.getTotal().charge[0] == 100LL * 1000);
+}
+
+void test_register_in_mah_and_wh()
+{
+    Energy::energy_total_t total;
+    total.charge[0] = 1500 * EM_REGISTER_DIVISOR; //1500 mAh
+    total.energy[0] = -70000LL * EM_REGISTER_DIVISOR; //-700 Wh
+    uint16_t buff[4] = {};
+    TEST_ASSERT_TRUE(total.readRegister(0, 4, buff));
+    TEST_ASSERT_EQUAL_HEX16(0, buff[0]);
+    TEST_ASSERT_EQUAL_HEX16(1500, buff[1]);
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)-70000, ((uint32_t)buff[2] << 16) | buff[3]);
+    TEST_ASSERT_FALSE(total.readRegister(EM_REGISTER_SIZE - 1, 2, buff));
+}
+
+void test_periodic_save_only_when_dirty()
+{
+    EnergyMeter meter;
+    meter.begin("energy", 60000);
+    uint32_t sent = Stub::queueSend;
+    Stub::now += 61000000;
+    meter.update(current, power, 0, 240); //nothing integrated yet
+    TEST_ASSERT_EQUAL_UINT32(sent, Stub::queueSend);
+    meter.update(current, power, 1000, 240);
+    TEST_ASSERT_EQUAL_UINT32(sent + 1, Stub::queueSend);
+    meter.update(current, power, 2000, 240); //inside the interval again
+    TEST_ASSERT_EQUAL_UINT32(sent + 1, Stub::queueSend);
+}
+
+void test_sag_inside_holdoff_is_saved_after_it()
+{
+    EnergyMeter meter;
+    meter.begin("energy", 3600000);
+    meter.setSagThreshold(220, 230);
+    uint32_t sent = Stub::queueSend;
+    meter.update(current, power, 0, 210);
+    TEST_ASSERT_EQUAL_UINT32(sent + 1, Stub::queueSend); //first sag is saved at once
+
+    Stub::now += 1000000;
+    meter.update(current, power, 1000, 240); //recover
+    Stub::now += 1000000;
+    meter.update(current, power, 2000, 210); //second sag inside the holdoff
+    TEST_ASSERT_EQUAL_UINT32(sent + 1, Stub::queueSend);
+    Stub::now += EM_SAG_HOLDOFF * 1000ULL;
+    meter.update(current, power, 3000, 240); //supply is back but the sag is still pending
+    TEST_ASSERT_EQUAL_UINT32(sent + 2, Stub::queueSend);
+    Stub::now += EM_SAG_HOLDOFF * 1000ULL;
+    meter.update(current, power, 4000, 240);
+    TEST_ASSERT_EQUAL_UINT32(sent + 2, Stub::queueSend); //saved once
+}
+
+void test_sag_is_saved_once_until_recover()
+{
+    EnergyMeter meter;
+    meter.begin("energy", 3600000);
+    meter.setSagThreshold(220, 230);
+    uint32_t sent = Stub::queueSend;
+    for (uint32_t i = 0; i < 5; i++)
+    {
+        Stub::now += EM_SAG_HOLDOFF * 1000ULL;
+        meter.update(current, power, i * 1000, 225); //between sag and recover, stay sagged
+    }
+    TEST_ASSERT_EQUAL_UINT32(sent, Stub::queueSend);
+    meter.update(current, power, 6000, 200);
+    TEST_ASSERT_EQUAL_UINT32(sent + 1, Stub::queueSend);
+    Stub::now += EM_SAG_HOLDOFF * 1000ULL;
+    meter.update(current, power, 7000, 200);
+    TEST_ASSERT_EQUAL_UINT32(sent + 1, Stub::queueSend);
+}
+
+void test_restore_total_from_flash()
+{
+    Energy::energy_total_t stored;
+    stored.energy[2] = 123456789;
+    Preferences preferences;
+    preferences.begin("energy");
+    preferences.putBytes("total", &stored, sizeof(stored));
+    preferences.end();
+
+    EnergyMeter meter;
+    TEST_ASSERT_TRUE(meter.begin("energy", 60000));
+    TEST_ASSERT_TRUE(meter.getTotal().energy[2] == 123456789);
+    meter.reset();
+    TEST_ASSERT_TRUE(meter.getTotal().energy[2] == 0);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_integrate_step);
+    RUN_TEST(test_step_above_max_is_skipped);
+    RUN_TEST(test_step_across_timer_wrap);
+    RUN_TEST(test_register_in_mah_and_wh);
+    RUN_TEST(test_periodic_save_only_when_dirty);
+    RUN_TEST(test_sag_inside_holdoff_is_saved_after_it);
+    RUN_TEST(test_sag_is_saved_once_until_recover);
+    RUN_TEST(test_restore_total_from_flash);
+    return UNITY_END();
+}
@@ -0,0 +1,128 @@
+#include <unity.h>
+#include <FixedScale.h>
+#include <cc6940.h>
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+/**
+ * Check every raw value of the range against the float conversion
+ *
+ * @param[in]   scale   conversion under test
+ * @param[in]   factor  exact register unit for each raw unit
+ * @param[in]   offset  raw value converted into 0
+ * @param[in]   first   first raw value
+ * @param[in]   last    last raw value
+ */
+static void checkErrorBound(const FixedScale &scale, double factor, int32_t offset, int32_t first, int32_t last)
+{
+    for (int32_t raw = first; raw <= last; raw++)
+    {
+        double expected = (raw - offset) * factor;
+        if (expected > INT16_MAX || expected < INT16_MIN)
+        {
+            continue;
+        }
+        double bound = 0.5 + fabs((double)(raw - offset)) / (1 << (FS_SHIFT + 1)) + 1e-9;
+        double error = fabs(scale.convert(raw) - expected);
+        if (error > bound)
+        {
+            char message[96];
+            snprintf(message, sizeof(message), "raw %d, error %.6f, bound %.6f", raw, error, bound);
+            TEST_FAIL_MESSAGE(message);
+        }
+    }
+}
+
+void test_cc6940_error_bound()
+{
+    CC6940 sensor;
+    const CC6940Type types[] = {CURRENT_10A, CURRENT_20A, CURRENT_30A};
+    for (CC6940Type type : types)
+    {
+        CC6940Config config = sensor.getPresetConfig(type);
+        config.offset = -7;
+        FixedScale scale = FixedScale::fromCC6940(config);
+        checkErrorBound(scale, 100.0 / config.resolution, config.midPoint + config.offset, 0, 3300);
+    }
+}
+
+void test_cc6940_error_bound_fine()
+{
+    CC6940 sensor;
+    CC6940Config config = sensor.getPresetConfig(CURRENT_10A);
+    FixedScale scale = FixedScale::fromCC6940(config, 5);
+    checkErrorBound(scale, 100.0 / config.resolution / 32, config.midPoint * 32, 0, 3300 * 32);
+}
+
+void test_cc6940_match_float_current()
+{
+    CC6940 sensor;
+    CC6940Config config = sensor.getPresetConfig(CURRENT_20A);
+    sensor.setup(config);
+    FixedScale scale = FixedScale::fromCC6940(config);
+    for (uint32_t mV = 0; mV <= 3300; mV++)
+    {
+        TEST_ASSERT_INT_WITHIN(1, lroundf(sensor.getCurrent(mV) * 100), scale.convert((int32_t)mV));
+    }
+}
+
+void test_voltage_error_bound()
+{
+    float voltPerCount = 6.144f / 32768; //ADS1115 at gain 2/3
+    FixedScale scale = FixedScale::fromVoltageFactor(voltPerCount, 101);
+    checkErrorBound(scale, (double)voltPerCount * 101 * 10, 0, INT16_MIN, INT16_MAX);
+}
+
+void test_block_convert()
+{
+    FixedScale scale;
+    TEST_ASSERT_TRUE(scale.setup(0.5f, 100));
+    const uint32_t unsignedRaw[] = {100, 101, 103, 300};
+    const int16_t signedRaw[] = {-100, 99, 102, 100};
+    int16_t out[4];
+    scale.convert(unsignedRaw, out, 4);
+    TEST_ASSERT_EQUAL_INT16(0, out[0]);
+    TEST_ASSERT_EQUAL_INT16(1, out[1]); //half is rounded up
+    TEST_ASSERT_EQUAL_INT16(2, out[2]);
+    TEST_ASSERT_EQUAL_INT16(100, out[3]);
+    scale.convert(signedRaw, out, 4);
+    TEST_ASSERT_EQUAL_INT16(-100, out[0]);
+    TEST_ASSERT_EQUAL_INT16(0, out[1]); //-0.5 is rounded up too
+    TEST_ASSERT_EQUAL_INT16(1, out[2]);
+    TEST_ASSERT_EQUAL_INT16(0, out[3]);
+}
+
+void test_saturation()
+{
+    FixedScale scale;
+    TEST_ASSERT_TRUE(scale.setup(100.0f));
+    TEST_ASSERT_EQUAL_INT16(INT16_MAX, scale.convert(1000));
+    TEST_ASSERT_EQUAL_INT16(INT16_MIN, scale.convert(-1000));
+}
+
+void test_reject_large_factor()
+{
+    FixedScale scale;
+    TEST_ASSERT_FALSE(scale.setup(40000.0f));
+    TEST_ASSERT_FALSE(scale.setup(-40000.0f));
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, scale.getFactor()); //previous scale is kept
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_cc6940_error_bound);
+    RUN_TEST(test_cc6940_error_bound_fine);
+    RUN_TEST(test_cc6940_match_float_current);
+    RUN_TEST(test_voltage_error_bound);
+    RUN_TEST(test_block_convert);
+    RUN_TEST(test_saturation);
+    RUN_TEST(test_reject_large_factor);
+    return UNITY_END();
+}
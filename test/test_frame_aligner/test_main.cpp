@@ -0,0 +1,138 @@
+#include <unity.h>
+#include <FrameAligner.h>
+
+/**
+ * Add voltage set, channel n is converted n x 1000 us after the first channel
+ *
+ * @param[in]   aligner aligner under test
+ * @param[in]   voltage voltage of every channel in 0.1 V
+ * @param[in]   start   conversion time of channel 0 in us
+ * @param[in]   sequence    set sequence
+ */
+static void addSet(FrameAligner &aligner, const std::array<int16_t, FA_VOLTAGE_CHANNEL> &voltage, uint32_t start, uint32_t sequence)
+{
+    std::array<uint32_t, FA_VOLTAGE_CHANNEL> timestamp;
+    for (size_t i = 0; i < FA_VOLTAGE_CHANNEL; i++)
+    {
+        timestamp[i] = start + i * 1000;
+    }
+    aligner.addVoltage(voltage, timestamp, sequence);
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_no_voltage_yet()
+{
+    FrameAligner aligner;
+    PowerSense::power_frame_t frame;
+    TEST_ASSERT_FALSE(aligner.align({100, 100, 100}, 0, frame));
+    addSet(aligner, {500, 500, 500, 500}, 0, 0); //sequence 0 is nothing posted
+    TEST_ASSERT_FALSE(aligner.align({100, 100, 100}, 0, frame));
+}
+
+void test_interpolate_between_set()
+{
+    FrameAligner aligner;
+    addSet(aligner, {500, 600, 700, 800}, 10000, 1);
+    addSet(aligner, {520, 640, 700, 700}, 20000, 2);
+    PowerSense::power_frame_t frame;
+    TEST_ASSERT_TRUE(aligner.align({0, 0, 0}, 15000, frame));
+    TEST_ASSERT_EQUAL_INT16(510, frame.voltage[0]); //halfway
+    TEST_ASSERT_EQUAL_INT16(616, frame.voltage[1]); //channel 1 is converted 1 ms later, 4 / 10 of the span
+    TEST_ASSERT_EQUAL_INT16(700, frame.voltage[2]);
+    TEST_ASSERT_EQUAL_INT16(780, frame.voltage[3]); //2 / 10 of the span
+    TEST_ASSERT_EQUAL_UINT32(15000, frame.timestamp);
+}
+
+void test_nearest_sample_outside_history()
+{
+    FrameAligner aligner;
+    addSet(aligner, {500, 500, 500, 500}, 10000, 1);
+    addSet(aligner, {600, 600, 600, 600}, 20000, 2);
+    PowerSense::power_frame_t frame;
+    aligner.align({0, 0, 0}, 5000, frame);
+    TEST_ASSERT_EQUAL_INT16(500, frame.voltage[0]); //before the oldest set
+    aligner.align({0, 0, 0}, 30000, frame);
+    TEST_ASSERT_EQUAL_INT16(600, frame.voltage[0]); //after the newest set
+    TEST_ASSERT_EQUAL_INT16(600, frame.voltage[3]);
+}
+
+void test_history_drop_oldest()
+{
+    FrameAligner aligner;
+    for (uint32_t i = 0; i < FA_HISTORY + 2; i++)
+    {
+        int16_t v = 500 + i * 10;
+        addSet(aligner, {v, v, v, v}, 10000 * (i + 1), i + 1);
+    }
+    PowerSense::power_frame_t frame;
+    aligner.align({0, 0, 0}, 0, frame);
+    TEST_ASSERT_EQUAL_INT16(520, frame.voltage[0]); //oldest kept set is the third
+}
+
+void test_same_sequence_is_ignored()
+{
+    FrameAligner aligner;
+    addSet(aligner, {500, 500, 500, 500}, 10000, 1);
+    addSet(aligner, {900, 900, 900, 900}, 20000, 1);
+    PowerSense::power_frame_t frame;
+    aligner.align({0, 0, 0}, 20000, frame);
+    TEST_ASSERT_EQUAL_INT16(500, frame.voltage[0]);
+}
+
+void test_power_use_load_voltage_channel()
+{
+    FrameAligner aligner;
+    for (size_t i = 0; i < FA_LOAD_CHANNEL; i++)
+    {
+        aligner.setLoadVoltage(i, 2 - i); //load 1 voltage is ADS channel 2, load 3 is channel 0 (program-latch wiring)
+    }
+    addSet(aligner, {300, 400, 500, 600}, 10000, 1);
+    PowerSense::power_frame_t frame;
+    aligner.align({100, 200, 300}, 10000, frame); //1 A, 2 A, 3 A
+    TEST_ASSERT_EQUAL_INT16(500, frame.power[0]); //50 V x 1 A = 50.0 W
+    TEST_ASSERT_EQUAL_INT16(800, frame.power[1]); //40 V x 2 A
+    TEST_ASSERT_EQUAL_INT16(900, frame.power[2]); //30 V x 3 A
+}
+
+void test_invalid_mapping_is_ignored()
+{
+    FrameAligner aligner;
+    aligner.setLoadVoltage(0, FA_VOLTAGE_CHANNEL);
+    aligner.setLoadVoltage(FA_LOAD_CHANNEL, 0);
+    addSet(aligner, {100, 200, 300, 400}, 0, 1);
+    PowerSense::power_frame_t frame;
+    aligner.align({100, 100, 100}, 0, frame);
+    TEST_ASSERT_EQUAL_INT16(100, frame.power[0]); //default mapping load n to channel n
+    TEST_ASSERT_EQUAL_INT16(300, frame.power[2]);
+}
+
+void test_power_saturate()
+{
+    FrameAligner aligner;
+    addSet(aligner, {INT16_MAX, -INT16_MAX, 0, 0}, 0, 1);
+    PowerSense::power_frame_t frame;
+    aligner.align({INT16_MAX, INT16_MAX, 0}, 0, frame);
+    TEST_ASSERT_EQUAL_INT16(INT16_MAX, frame.power[0]);
+    TEST_ASSERT_EQUAL_INT16(INT16_MIN, frame.power[1]);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_no_voltage_yet);
+    RUN_TEST(test_interpolate_between_set);
+    RUN_TEST(test_nearest_sample_outside_history);
+    RUN_TEST(test_history_drop_oldest);
+    RUN_TEST(test_same_sequence_is_ignored);
+    RUN_TEST(test_power_use_load_voltage_channel);
+    RUN_TEST(test_invalid_mapping_is_ignored);
+    RUN_TEST(test_power_saturate);
+    return UNITY_END();
+}
@@ -0,0 +1,250 @@
+#include <unity.h>
+#include <new>
+#include <LoadModbusServer.h>
+
+static size_t allocation = 0; //number of operator new call
+
+void *operator new(size_t size)
+{
+    allocation++;
+    void *ptr = malloc(size ? size : 1);
+    if (ptr == NULL)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+static std::array<uint16_t, 150> holding = {}; //0x1000 - 0x1095 in two block
+static std::array<uint16_t, 125> input = {}; //0x2000 - 0x207C
+static CoilData coils(32);
+static LoadModbusServer handler;
+
+/**
+ * Count heap allocation made by call
+ *
+ * @param[in]   call    function to be measured
+ *
+ * @return  number of allocation
+ */
+template <typename Call>
+static size_t countAllocation(Call call)
+{
+    size_t before = allocation;
+    call();
+    return allocation - before;
+}
+
+/**
+ * Count heap allocation of an exception response built directly by eModbus
+ *
+ * @return  number of allocation
+ */
+static size_t exceptionAllocation()
+{
+    ModbusMessage response;
+    return countAllocation([&] { response.setError(1, READ_HOLD_REGISTER, ILLEGAL_DATA_ADDRESS); });
+}
+
+/**
+ * Build request with address and quantity field
+ *
+ * @param[in]   functionCode    function code
+ * @param[in]   address start address
+ * @param[in]   count   quantity or value field
+ *
+ * @return  request message
+ */
+static ModbusMessage makeRequest(uint8_t functionCode, uint16_t address, uint16_t count)
+{
+    ModbusMessage request;
+    request.add((uint8_t)1, functionCode, address, count);
+    return request;
+}
+
+void setUp()
+{
+    for (size_t i = 0; i < holding.size(); i++)
+    {
+        holding[i] = 0x1000 + i;
+    }
+    for (size_t i = 0; i < input.size(); i++)
+    {
+        input[i] = 0x2000 + i;
+    }
+    for (size_t i = 0; i < coils.coils(); i++)
+    {
+        coils.set(i, i % 3 == 0);
+    }
+}
+
+void tearDown()
+{
+}
+
+void test_read_holding_register_across_block()
+{
+    ModbusMessage request = makeRequest(READ_HOLD_REGISTER, 0x1000, LMS_MAX_READ_REGISTER);
+    ModbusMessage response;
+    TEST_ASSERT_EQUAL_UINT32(1, countAllocation([&] { response = handler.readHoldingRegister(request); }));
+    TEST_ASSERT_EQUAL_UINT8(SUCCESS, response.getError());
+    TEST_ASSERT_EQUAL_UINT16(3 + LMS_MAX_READ_REGISTER * 2, response.size());
+    for (uint16_t i = 0; i < LMS_MAX_READ_REGISTER; i++)
+    {
+        uint16_t value = 0;
+        response.get(3 + i * 2, value);
+        TEST_ASSERT_EQUAL_HEX16(0x1000 + i, value);
+    }
+}
+
+void test_read_input_register()
+{
+    ModbusMessage request = makeRequest(READ_INPUT_REGISTER, 0x2000, LMS_MAX_READ_REGISTER);
+    ModbusMessage response;
+    TEST_ASSERT_EQUAL_UINT32(1, countAllocation([&] { response = handler.readInputRegister(request); }));
+    uint16_t last = 0;
+    response.get(3 + (LMS_MAX_READ_REGISTER - 1) * 2, last);
+    TEST_ASSERT_EQUAL_HEX16(0x2000 + LMS_MAX_READ_REGISTER - 1, last);
+}
+
+void test_read_coil()
+{
+    ModbusMessage request = makeRequest(READ_COIL, 0, 32);
+    ModbusMessage response;
+    TEST_ASSERT_EQUAL_UINT32(1, countAllocation([&] { response = handler.readCoil(request); }));
+    TEST_ASSERT_EQUAL_UINT16(3 + 4, response.size());
+    TEST_ASSERT_EQUAL_HEX8(0x49, response[3]); //coil 0, 3 and 6
+}
+
+void test_write_coil()
+{
+    ModbusMessage request = makeRequest(WRITE_COIL, 1, 0xFF00);
+    ModbusMessage response;
+    TEST_ASSERT_EQUAL_UINT32(1, countAllocation([&] { response = handler.writeCoil(request); }));
+    TEST_ASSERT_TRUE(response == ECHO_RESPONSE);
+    TEST_ASSERT_TRUE(coils[1]);
+}
+
+void test_write_multiple_coil()
+{
+    ModbusMessage request;
+    request.add((uint8_t)1, (uint8_t)WRITE_MULT_COILS, (uint16_t)0, (uint16_t)16, (uint8_t)2, (uint8_t)0xFF, (uint8_t)0x00);
+    ModbusMessage response;
+    TEST_ASSERT_EQUAL_UINT32(1, countAllocation([&] { response = handler.writeMultipleCoil(request); }));
+    TEST_ASSERT_EQUAL_UINT16(6, response.size());
+    TEST_ASSERT_TRUE(coils[1]);
+    TEST_ASSERT_FALSE(coils[9]);
+}
+
+void test_write_holding_register()
+{
+    ModbusMessage request = makeRequest(WRITE_HOLD_REGISTER, 0x1001, 0xBEEF);
+    ModbusMessage response;
+    TEST_ASSERT_EQUAL_UINT32(1, countAllocation([&] { response = handler.writeHoldingRegister(request); }));
+    TEST_ASSERT_TRUE(response == ECHO_RESPONSE);
+    TEST_ASSERT_EQUAL_HEX16(0xBEEF, holding[1]);
+}
+
+void test_write_multiple_holding_register_across_block()
+{
+    ModbusMessage request;
+    request.add((uint8_t)1, (uint8_t)WRITE_MULT_REGISTERS, (uint16_t)0x1010, (uint16_t)LMS_MAX_WRITE_REGISTER, (uint8_t)(LMS_MAX_WRITE_REGISTER * 2));
+    for (uint16_t i = 0; i < LMS_MAX_WRITE_REGISTER; i++)
+    {
+        request.add((uint16_t)(0xA000 + i));
+    }
+    ModbusMessage response;
+    TEST_ASSERT_EQUAL_UINT32(1, countAllocation([&] { response = handler.writeMultipleHoldingRegister(request); }));
+    TEST_ASSERT_EQUAL_UINT16(6, response.size());
+    TEST_ASSERT_EQUAL_HEX16(0xA000, holding[0x10]);
+    TEST_ASSERT_EQUAL_HEX16(0xA000 + LMS_MAX_WRITE_REGISTER - 1, holding[0x10 + LMS_MAX_WRITE_REGISTER - 1]);
+}
+
+void test_read_write_multiple_register()
+{
+    ModbusMessage request;
+    request.add((uint8_t)1, (uint8_t)R_W_MULT_REGISTERS, (uint16_t)0x1000, (uint16_t)4, (uint16_t)0x1002, (uint16_t)1, (uint8_t)2, (uint16_t)0x1234);
+    ModbusMessage response;
+    TEST_ASSERT_EQUAL_UINT32(1, countAllocation([&] { response = handler.readWriteMultipleRegister(request); }));
+    TEST_ASSERT_EQUAL_UINT16(3 + 8, response.size());
+    uint16_t value = 0;
+    response.get(3 + 2 * 2, value);
+    TEST_ASSERT_EQUAL_HEX16(0x1234, value); //write is executed before read
+}
+
+void test_read_device_identification()
+{
+    ModbusMessage request;
+    request.add((uint8_t)1, (uint8_t)ENCAPSULATED_INTERFACE, (uint8_t)0x0E, (uint8_t)0x01, (uint8_t)0x00);
+    ModbusMessage response;
+    TEST_ASSERT_EQUAL_UINT32(1, countAllocation([&] { response = handler.readDeviceIdentification(request); }));
+    TEST_ASSERT_EQUAL_UINT8(SUCCESS, response.getError());
+    TEST_ASSERT_EQUAL_UINT8(3, response[7]); //vendor, product code and revision
+}
+
+void test_exception_add_no_allocation()
+{
+    size_t expected = exceptionAllocation();
+    ModbusMessage response;
+    ModbusMessage unmapped = makeRequest(READ_HOLD_REGISTER, 0x0FFF, 2);
+    ModbusMessage tooLarge = makeRequest(READ_INPUT_REGISTER, 0x2000, LMS_MAX_READ_REGISTER + 1);
+    ModbusMessage badCoil = makeRequest(WRITE_COIL, 1, 0x1234);
+    ModbusMessage readOnly = makeRequest(WRITE_HOLD_REGISTER, 0x2000, 1);
+    TEST_ASSERT_EQUAL_UINT32(expected, countAllocation([&] { response = handler.readHoldingRegister(unmapped); }));
+    TEST_ASSERT_EQUAL_UINT8(ILLEGAL_DATA_ADDRESS, response.getError());
+    TEST_ASSERT_EQUAL_UINT32(expected, countAllocation([&] { response = handler.readInputRegister(tooLarge); }));
+    TEST_ASSERT_EQUAL_UINT8(ILLEGAL_DATA_VALUE, response.getError());
+    TEST_ASSERT_EQUAL_UINT32(expected, countAllocation([&] { response = handler.writeCoil(badCoil); }));
+    TEST_ASSERT_EQUAL_UINT8(ILLEGAL_DATA_VALUE, response.getError());
+    TEST_ASSERT_EQUAL_UINT32(expected, countAllocation([&] { response = handler.writeHoldingRegister(readOnly); }));
+    TEST_ASSERT_EQUAL_UINT8(ILLEGAL_DATA_ADDRESS, response.getError());
+}
+
+int main()
+{
+    auto readHolding = [](uint16_t offset) {
+        return [offset](uint16_t index, uint16_t count, uint16_t *buff) {
+            memcpy(buff, holding.data() + offset + index, count * sizeof(uint16_t));
+            return true;
+        };
+    };
+    auto writeHolding = [](uint16_t offset) {
+        return [offset](uint16_t index, uint16_t count, uint16_t *buff) {
+            memcpy(holding.data() + offset + index, buff, count * sizeof(uint16_t));
+            return true;
+        };
+    };
+    handler.addHoldingRegister(0x1000, 100, readHolding(0), writeHolding(0));
+    handler.addHoldingRegister(0x1064, 50, readHolding(100), writeHolding(100));
+    handler.addInputRegister(0x2000, 125, [](uint16_t index, uint16_t count, uint16_t *buff) {
+        memcpy(buff, input.data() + index, count * sizeof(uint16_t));
+        return true;
+    });
+    handler.setCoil(0, &coils);
+    handler.setDeviceObject(LoadModbus::VENDOR_NAME, "vendor");
+    handler.setDeviceObject(LoadModbus::PRODUCT_CODE, "code");
+    handler.setDeviceObject(LoadModbus::MAJOR_MINOR_REVISION, "1.0");
+
+    UNITY_BEGIN();
+    RUN_TEST(test_read_holding_register_across_block);
+    RUN_TEST(test_read_input_register);
+    RUN_TEST(test_read_coil);
+    RUN_TEST(test_write_coil);
+    RUN_TEST(test_write_multiple_coil);
+    RUN_TEST(test_write_holding_register);
+    RUN_TEST(test_write_multiple_holding_register_across_block);
+    RUN_TEST(test_read_write_multiple_register);
+    RUN_TEST(test_read_device_identification);
+    RUN_TEST(test_exception_add_no_allocation);
+    return UNITY_END();
+}
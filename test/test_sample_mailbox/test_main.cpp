@@ -0,0 +1,80 @@
+#include <unity.h>
+#include <SeqLock.h>
+
+void setUp()
+{
+    Stub::now = 5000000;
+}
+
+void tearDown()
+{
+}
+
+void test_nothing_posted()
+{
+    SampleMailbox<int16_t> mailbox;
+    int16_t value = 1;
+    TEST_ASSERT_EQUAL_UINT32(0, mailbox.read(value));
+    TEST_ASSERT_EQUAL_INT16(0, value);
+    TEST_ASSERT_TRUE(mailbox.isStale(UINT32_MAX));
+}
+
+void test_read_latest_with_timestamp()
+{
+    SampleMailbox<int16_t> mailbox;
+    mailbox.post(10, 100);
+    mailbox.post(20);
+    int16_t value = 0;
+    uint32_t timestamp = 0;
+    TEST_ASSERT_EQUAL_UINT32(2, mailbox.read(value, timestamp));
+    TEST_ASSERT_EQUAL_INT16(20, value);
+    TEST_ASSERT_EQUAL_UINT32(5000000, timestamp);
+}
+
+void test_sequence_wrap_skip_zero()
+{
+    SampleMailbox<int16_t> mailbox(UINT32_MAX - 1);
+    int16_t value = 0;
+    mailbox.post(1);
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, mailbox.read(value));
+    mailbox.post(2);
+    TEST_ASSERT_EQUAL_UINT32(1, mailbox.read(value)); //0 is kept for nothing posted
+    TEST_ASSERT_EQUAL_INT16(2, value);
+    TEST_ASSERT_FALSE(mailbox.isStale(1000));
+    mailbox.post(3);
+    TEST_ASSERT_EQUAL_UINT32(2, mailbox.read(value));
+}
+
+void test_stale_after_max_age()
+{
+    SampleMailbox<int16_t> mailbox;
+    mailbox.post(1);
+    Stub::now += 1000;
+    TEST_ASSERT_FALSE(mailbox.isStale(1000)); //exactly max age
+    Stub::now += 1;
+    TEST_ASSERT_TRUE(mailbox.isStale(1000));
+    mailbox.post(2);
+    TEST_ASSERT_FALSE(mailbox.isStale(1000));
+}
+
+void test_stale_across_timer_wrap()
+{
+    SampleMailbox<int16_t> mailbox;
+    Stub::now = UINT32_MAX - 100;
+    mailbox.post(1);
+    Stub::now = (uint64_t)UINT32_MAX + 500; //micros wrap on 32 bit
+    TEST_ASSERT_FALSE(mailbox.isStale(1000));
+    Stub::now += 1000;
+    TEST_ASSERT_TRUE(mailbox.isStale(1000));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_nothing_posted);
+    RUN_TEST(test_read_latest_with_timestamp);
+    RUN_TEST(test_sequence_wrap_skip_zero);
+    RUN_TEST(test_stale_after_max_age);
+    RUN_TEST(test_stale_across_timer_wrap);
+    return UNITY_END();
+}
@@ -0,0 +1,170 @@
+#include <unity.h>
+#include <thread>
+#include <atomic>
+#include <LoadModbusServer.h>
+
+/**
+ * Local server standing in for ModbusServerRTU and ModbusServerEthernet, request is passed through localRequest
+ *
+ * @brief   only the shared handler is covered here. the MBAP framing and the socket path of ModbusServerEthernet
+ *          need the W5x00 Ethernet library and the FreeRTOS task API, so FC03 and FC10 over a real TCP connection
+ *          are not tested natively and are left to the board
+ */
+class LocalServer : public ModbusServer
+{
+};
+
+static std::array<uint16_t, 64> holding = {}; //0x1000 - 0x103F in two block
+static CoilData coils(16);
+static LoadModbusServer handler;
+static LocalServer rtuServer;
+static LocalServer tcpServer;
+
+/**
+ * Build FC10 request writing the same value into every register
+ *
+ * @param[in]   address start address
+ * @param[in]   count   number of register
+ * @param[in]   value   register value
+ *
+ * @return  request message
+ */
+static ModbusMessage makeWrite(uint16_t address, uint16_t count, uint16_t value)
+{
+    ModbusMessage request;
+    request.add((uint8_t)1, (uint8_t)WRITE_MULT_REGISTERS, address, count, (uint8_t)(count * 2));
+    for (uint16_t i = 0; i < count; i++)
+    {
+        request.add(value);
+    }
+    return request;
+}
+
+/**
+ * Build read request
+ *
+ * @param[in]   functionCode    function code
+ * @param[in]   address start address
+ * @param[in]   count   number of register or coil
+ *
+ * @return  request message
+ */
+static ModbusMessage makeRead(uint8_t functionCode, uint16_t address, uint16_t count)
+{
+    ModbusMessage request;
+    request.add((uint8_t)1, functionCode, address, count);
+    return request;
+}
+
+void setUp()
+{
+    for (size_t i = 0; i < holding.size(); i++)
+    {
+        holding[i] = i;
+    }
+}
+
+void tearDown()
+{
+}
+
+void test_same_response_on_both_server()
+{
+    ModbusMessage request = makeRead(READ_HOLD_REGISTER, 0x1000, holding.size());
+    ModbusMessage rtuResponse = rtuServer.localRequest(request);
+    ModbusMessage tcpResponse = tcpServer.localRequest(request);
+    TEST_ASSERT_EQUAL_UINT8(SUCCESS, rtuResponse.getError());
+    TEST_ASSERT_TRUE(rtuResponse == tcpResponse);
+}
+
+void test_write_is_visible_on_other_server()
+{
+    ModbusMessage response = tcpServer.localRequest(makeWrite(0x101E, 4, 0xCAFE));
+    TEST_ASSERT_EQUAL_UINT8(SUCCESS, response.getError());
+    response = rtuServer.localRequest(makeRead(READ_HOLD_REGISTER, 0x101E, 4));
+    for (uint16_t i = 0; i < 4; i++)
+    {
+        uint16_t value = 0;
+        response.get(3 + i * 2, value);
+        TEST_ASSERT_EQUAL_HEX16(0xCAFE, value);
+    }
+}
+
+void test_coil_is_shared()
+{
+    ModbusMessage write;
+    write.add((uint8_t)1, (uint8_t)WRITE_MULT_COILS, (uint16_t)0, (uint16_t)8, (uint8_t)1, (uint8_t)0xA5);
+    TEST_ASSERT_EQUAL_UINT8(SUCCESS, rtuServer.localRequest(write).getError());
+    ModbusMessage response = tcpServer.localRequest(makeRead(READ_COIL, 0, 8));
+    TEST_ASSERT_EQUAL_UINT8(SUCCESS, response.getError());
+    TEST_ASSERT_EQUAL_HEX8(0xA5, response[3]);
+}
+
+void test_concurrent_client_never_see_torn_write()
+{
+    const uint16_t round = 2000;
+    std::atomic<bool> isTorn(false);
+    std::thread writer([&] {
+        for (uint16_t i = 0; i < round; i++)
+        {
+            tcpServer.localRequest(makeWrite(0x1000, holding.size(), i));
+        }
+    });
+    std::thread reader([&] {
+        ModbusMessage request = makeRead(READ_HOLD_REGISTER, 0x1000, holding.size());
+        for (uint16_t i = 0; i < round && !isTorn; i++)
+        {
+            ModbusMessage response = rtuServer.localRequest(request);
+            uint16_t first = 0;
+            response.get(3, first);
+            for (uint16_t n = 1; n < holding.size(); n++)
+            {
+                uint16_t value = 0;
+                response.get(3 + n * 2, value);
+                if (value != first)
+                {
+                    isTorn = true; //write across both block must be seen as a whole
+                    break;
+                }
+            }
+        }
+    });
+    writer.join();
+    reader.join();
+    TEST_ASSERT_FALSE(isTorn);
+}
+
+int main()
+{
+    auto readHolding = [](uint16_t offset) {
+        return [offset](uint16_t index, uint16_t count, uint16_t *buff) {
+            for (uint16_t i = 0; i < count; i++)
+            {
+                buff[i] = holding[offset + index + i];
+            }
+            return true;
+        };
+    };
+    auto writeHolding = [](uint16_t offset) {
+        return [offset](uint16_t index, uint16_t count, uint16_t *buff) {
+            for (uint16_t i = 0; i < count; i++)
+            {
+                holding[offset + index + i] = buff[i];
+            }
+            std::this_thread::yield(); //widen the window between the two block write
+            return true;
+        };
+    };
+    handler.addHoldingRegister(0x1000, 32, readHolding(0), writeHolding(0));
+    handler.addHoldingRegister(0x1020, 32, readHolding(32), writeHolding(32));
+    handler.setCoil(0, &coils);
+    handler.registerWorker(rtuServer, 1);
+    handler.registerWorker(tcpServer, 1);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_same_response_on_both_server);
+    RUN_TEST(test_write_is_visible_on_other_server);
+    RUN_TEST(test_coil_is_shared);
+    RUN_TEST(test_concurrent_client_never_see_torn_write);
+    return UNITY_END();
+}
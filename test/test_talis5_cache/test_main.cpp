@@ -0,0 +1,262 @@
+#include <unity.h>
+#include <Talis5Cache.h>
+
+void setUp()
+{
+    Stub::now = 10000000;
+}
+
+void tearDown()
+{
+}
+
+/**
+ * Build read request
+ *
+ * @param[in]   unit    unit id
+ * @param[in]   functionCode    READ_HOLD_REGISTER or READ_INPUT_REGISTER
+ * @param[in]   address start address
+ * @param[in]   count   number of register
+ *
+ * @return  request message
+ */
+static ModbusMessage makeRead(uint8_t unit, uint8_t functionCode, uint16_t address, uint16_t count)
+{
+    ModbusMessage request;
+    request.add(unit, functionCode, address, count);
+    return request;
+}
+
+/**
+ * Build read response, register value is its address
+ *
+ * @param[in]   request read request
+ *
+ * @return  response message
+ */
+static ModbusMessage makeResponse(const ModbusMessage &request)
+{
+    uint16_t address = 0;
+    uint16_t count = 0;
+    request.get(2, address, count);
+    ModbusMessage response;
+    response.add(request.getServerID(), request.getFunctionCode(), (uint8_t)(count * 2));
+    for (uint16_t i = 0; i < count; i++)
+    {
+        response.add((uint16_t)(address + i));
+    }
+    return response;
+}
+
+/**
+ * Store response of read request and check that it is cached
+ *
+ * @param[in]   cache   cache under test
+ * @param[in]   request read request
+ */
+static void storeRead(Talis5Cache &cache, const ModbusMessage &request)
+{
+    cache.store(request, makeResponse(request));
+    ModbusMessage response;
+    TEST_ASSERT_TRUE(cache.lookup(request, response));
+}
+
+/**
+ * Check if request is answered from cache
+ *
+ * @param[in]   cache   cache under test
+ * @param[in]   request read request
+ *
+ * @return  true if cached
+ */
+static bool isCached(Talis5Cache &cache, const ModbusMessage &request)
+{
+    ModbusMessage response;
+    return cache.lookup(request, response);
+}
+
+void test_hit_within_ttl()
+{
+    Talis5Cache cache;
+    TEST_ASSERT_TRUE(cache.addRule(READ_HOLD_REGISTER, 0x100, 10, 500));
+    ModbusMessage request = makeRead(1, READ_HOLD_REGISTER, 0x100, 4);
+    ModbusMessage response;
+    TEST_ASSERT_FALSE(cache.lookup(request, response));
+    cache.store(request, makeResponse(request));
+
+    Stub::now += 499000;
+    TEST_ASSERT_TRUE(cache.lookup(request, response));
+    TEST_ASSERT_TRUE(response == makeResponse(request));
+    Stub::now += 1000;
+    TEST_ASSERT_FALSE(isCached(cache, request)); //expired at ttl
+    TEST_ASSERT_EQUAL_UINT32(1, cache.getHit());
+    TEST_ASSERT_EQUAL_UINT32(2, cache.getMiss());
+}
+
+void test_range_outside_rule_is_not_cached()
+{
+    Talis5Cache cache;
+    cache.addRule(READ_HOLD_REGISTER, 0x100, 10, 500);
+    ModbusMessage partial = makeRead(1, READ_HOLD_REGISTER, 0x108, 4);
+    ModbusMessage input = makeRead(1, READ_INPUT_REGISTER, 0x100, 4);
+    cache.store(partial, makeResponse(partial));
+    cache.store(input, makeResponse(input));
+    TEST_ASSERT_FALSE(isCached(cache, partial));
+    TEST_ASSERT_FALSE(isCached(cache, input));
+    TEST_ASSERT_EQUAL_UINT32(0, cache.getMiss()); //uncacheable request is not counted
+}
+
+void test_shortest_ttl_is_used()
+{
+    Talis5Cache cache;
+    cache.addRule(READ_INPUT_REGISTER, 0, 100, 1000);
+    cache.addRule(READ_INPUT_REGISTER, 10, 10, 200);
+    ModbusMessage request = makeRead(1, READ_INPUT_REGISTER, 12, 2);
+    cache.store(request, makeResponse(request));
+    Stub::now += 199000;
+    TEST_ASSERT_TRUE(isCached(cache, request));
+    Stub::now += 1000;
+    TEST_ASSERT_FALSE(isCached(cache, request));
+}
+
+void test_rule_is_validated()
+{
+    Talis5Cache cache;
+    TEST_ASSERT_FALSE(cache.addRule(WRITE_HOLD_REGISTER, 0, 10, 100));
+    TEST_ASSERT_FALSE(cache.addRule(READ_HOLD_REGISTER, 0, 0, 100));
+    TEST_ASSERT_FALSE(cache.addRule(READ_HOLD_REGISTER, 0, 10, 0));
+    for (size_t i = 0; i < T5C_MAX_RULE; i++)
+    {
+        TEST_ASSERT_TRUE(cache.addRule(READ_HOLD_REGISTER, i * 10, 10, 100));
+    }
+    TEST_ASSERT_FALSE(cache.addRule(READ_HOLD_REGISTER, 0, 10, 100));
+}
+
+void test_error_response_is_not_stored()
+{
+    Talis5Cache cache;
+    cache.addRule(READ_HOLD_REGISTER, 0, 10, 500);
+    ModbusMessage request = makeRead(1, READ_HOLD_REGISTER, 0, 2);
+    ModbusMessage response;
+    response.setError(1, READ_HOLD_REGISTER, ILLEGAL_DATA_ADDRESS);
+    cache.store(request, response);
+    TEST_ASSERT_FALSE(isCached(cache, request));
+}
+
+void test_entry_is_keyed_by_unit()
+{
+    Talis5Cache cache;
+    cache.addRule(READ_HOLD_REGISTER, 0, 10, 500);
+    storeRead(cache, makeRead(1, READ_HOLD_REGISTER, 0, 2));
+    TEST_ASSERT_FALSE(isCached(cache, makeRead(2, READ_HOLD_REGISTER, 0, 2)));
+    TEST_ASSERT_FALSE(isCached(cache, makeRead(1, READ_HOLD_REGISTER, 0, 3)));
+}
+
+void test_single_write_invalidate_overlap()
+{
+    Talis5Cache cache;
+    cache.addRule(READ_HOLD_REGISTER, 0x100, 16, 500);
+    ModbusMessage low = makeRead(1, READ_HOLD_REGISTER, 0x100, 4);
+    ModbusMessage high = makeRead(1, READ_HOLD_REGISTER, 0x104, 4);
+    storeRead(cache, low);
+    storeRead(cache, high);
+
+    ModbusMessage write;
+    write.add((uint8_t)1, (uint8_t)WRITE_HOLD_REGISTER, (uint16_t)0x103, (uint16_t)0x1234);
+    cache.invalidate(write);
+    TEST_ASSERT_FALSE(isCached(cache, low));
+    TEST_ASSERT_TRUE(isCached(cache, high));
+    TEST_ASSERT_EQUAL_UINT32(1, cache.getInvalidate());
+}
+
+void test_multiple_write_invalidate_range()
+{
+    Talis5Cache cache;
+    cache.addRule(READ_HOLD_REGISTER, 0x100, 16, 500);
+    cache.addRule(READ_INPUT_REGISTER, 0x100, 16, 500);
+    ModbusMessage low = makeRead(1, READ_HOLD_REGISTER, 0x100, 4);
+    ModbusMessage middle = makeRead(1, READ_HOLD_REGISTER, 0x104, 4);
+    ModbusMessage high = makeRead(1, READ_HOLD_REGISTER, 0x108, 4);
+    ModbusMessage input = makeRead(1, READ_INPUT_REGISTER, 0x10C, 4);
+    ModbusMessage other = makeRead(2, READ_INPUT_REGISTER, 0x10C, 4);
+    storeRead(cache, low);
+    storeRead(cache, middle);
+    storeRead(cache, high);
+    storeRead(cache, input);
+    storeRead(cache, other);
+
+    ModbusMessage write;
+    write.add((uint8_t)1, (uint8_t)WRITE_MULT_REGISTERS, (uint16_t)0x103, (uint16_t)2, (uint8_t)4, (uint16_t)1, (uint16_t)2);
+    cache.invalidate(write);
+    TEST_ASSERT_FALSE(isCached(cache, low));
+    TEST_ASSERT_FALSE(isCached(cache, middle));
+    TEST_ASSERT_TRUE(isCached(cache, high));
+    TEST_ASSERT_FALSE(isCached(cache, input)); //telemetry may follow any holding write
+    TEST_ASSERT_TRUE(isCached(cache, other));
+    TEST_ASSERT_EQUAL_UINT32(3, cache.getInvalidate());
+}
+
+void test_read_write_invalidate_write_range()
+{
+    Talis5Cache cache;
+    cache.addRule(READ_HOLD_REGISTER, 0x100, 16, 500);
+    ModbusMessage low = makeRead(1, READ_HOLD_REGISTER, 0x100, 4);
+    ModbusMessage high = makeRead(1, READ_HOLD_REGISTER, 0x108, 4);
+    storeRead(cache, low);
+    storeRead(cache, high);
+
+    ModbusMessage write; //read 0x100 - 0x103, write 0x108
+    write.add((uint8_t)1, (uint8_t)R_W_MULT_REGISTERS, (uint16_t)0x100, (uint16_t)4, (uint16_t)0x108, (uint16_t)1, (uint8_t)2, (uint16_t)7);
+    cache.invalidate(write);
+    TEST_ASSERT_TRUE(isCached(cache, low)); //read range is not invalidated
+    TEST_ASSERT_FALSE(isCached(cache, high));
+}
+
+void test_coil_write_invalidate_unit()
+{
+    Talis5Cache cache;
+    cache.addRule(READ_HOLD_REGISTER, 0, 16, 500);
+    cache.addRule(READ_INPUT_REGISTER, 0, 16, 500);
+    ModbusMessage holding = makeRead(1, READ_HOLD_REGISTER, 0, 4);
+    ModbusMessage input = makeRead(1, READ_INPUT_REGISTER, 8, 4);
+    ModbusMessage other = makeRead(2, READ_HOLD_REGISTER, 0, 4);
+    storeRead(cache, holding);
+    storeRead(cache, input);
+    storeRead(cache, other);
+
+    ModbusMessage write;
+    write.add((uint8_t)1, (uint8_t)WRITE_COIL, (uint16_t)3, (uint16_t)0xFF00);
+    cache.invalidate(write);
+    TEST_ASSERT_FALSE(isCached(cache, holding));
+    TEST_ASSERT_FALSE(isCached(cache, input));
+    TEST_ASSERT_TRUE(isCached(cache, other));
+    TEST_ASSERT_EQUAL_UINT32(2, cache.getInvalidate());
+}
+
+void test_read_does_not_invalidate()
+{
+    Talis5Cache cache;
+    cache.addRule(READ_HOLD_REGISTER, 0, 16, 500);
+    ModbusMessage request = makeRead(1, READ_HOLD_REGISTER, 0, 4);
+    storeRead(cache, request);
+    cache.invalidate(request);
+    TEST_ASSERT_TRUE(isCached(cache, request));
+    TEST_ASSERT_EQUAL_UINT32(0, cache.getInvalidate());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_hit_within_ttl);
+    RUN_TEST(test_range_outside_rule_is_not_cached);
+    RUN_TEST(test_shortest_ttl_is_used);
+    RUN_TEST(test_rule_is_validated);
+    RUN_TEST(test_error_response_is_not_stored);
+    RUN_TEST(test_entry_is_keyed_by_unit);
+    RUN_TEST(test_single_write_invalidate_overlap);
+    RUN_TEST(test_multiple_write_invalidate_range);
+    RUN_TEST(test_read_write_invalidate_write_range);
+    RUN_TEST(test_coil_write_invalidate_unit);
+    RUN_TEST(test_read_does_not_invalidate);
+    return UNITY_END();
+}
@@ -0,0 +1,263 @@
+#include <unity.h>
+#include <Talis5Policy.h>
+
+/**
+ * Poll and gateway policy of Talis5Poller and Talis5Gateway
+ *
+ * @brief   the poller decision (merge, timeout, backoff, liveness) is tested here without the bus. Talis5Poller
+ *          itself is not run against a fake RTU client because it hold a concrete ModbusClientRTU, which need
+ *          HardwareSerial and its own FreeRTOS task, so the request sequence on the bus is verified on the board
+ */
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+/**
+ * Build register range
+ *
+ * @param[in]   functionCode    READ_HOLD_REGISTER or READ_INPUT_REGISTER
+ * @param[in]   address start address
+ * @param[in]   count   number of register
+ *
+ * @return  register range
+ */
+static Talis5::poll_range_t makeRange(uint8_t functionCode, uint16_t address, uint16_t count)
+{
+    Talis5::poll_range_t range;
+    range.functionCode = functionCode;
+    range.address = address;
+    range.count = count;
+    return range;
+}
+
+void test_merge_contiguous_range()
+{
+    std::vector<Talis5::poll_range_t> batch;
+    uint16_t cacheSize = Talis5Policy::mergeRange({makeRange(READ_HOLD_REGISTER, 110, 5), makeRange(READ_HOLD_REGISTER, 100, 10)}, batch);
+    TEST_ASSERT_EQUAL_size_t(1, batch.size());
+    TEST_ASSERT_EQUAL_UINT16(100, batch[0].address);
+    TEST_ASSERT_EQUAL_UINT16(15, batch[0].count);
+    TEST_ASSERT_EQUAL_UINT16(15, cacheSize);
+}
+
+void test_never_merge_across_gap()
+{
+    std::vector<Talis5::poll_range_t> batch;
+    uint16_t cacheSize = Talis5Policy::mergeRange({makeRange(READ_HOLD_REGISTER, 100, 10), makeRange(READ_HOLD_REGISTER, 111, 5)}, batch);
+    TEST_ASSERT_EQUAL_size_t(2, batch.size()); //register 110 is not read
+    TEST_ASSERT_EQUAL_UINT16(10, batch[0].count);
+    TEST_ASSERT_EQUAL_UINT16(111, batch[1].address);
+    TEST_ASSERT_EQUAL_UINT16(0, batch[0].offset);
+    TEST_ASSERT_EQUAL_UINT16(10, batch[1].offset);
+    TEST_ASSERT_EQUAL_UINT16(15, cacheSize);
+}
+
+void test_merge_overlapping_range()
+{
+    std::vector<Talis5::poll_range_t> batch;
+    uint16_t cacheSize = Talis5Policy::mergeRange({makeRange(READ_INPUT_REGISTER, 0, 20), makeRange(READ_INPUT_REGISTER, 5, 5), makeRange(READ_INPUT_REGISTER, 15, 10)}, batch);
+    TEST_ASSERT_EQUAL_size_t(1, batch.size());
+    TEST_ASSERT_EQUAL_UINT16(25, batch[0].count);
+    TEST_ASSERT_EQUAL_UINT16(25, cacheSize);
+}
+
+void test_never_merge_function_code()
+{
+    std::vector<Talis5::poll_range_t> batch;
+    uint16_t cacheSize = Talis5Policy::mergeRange({makeRange(READ_INPUT_REGISTER, 0, 10), makeRange(READ_HOLD_REGISTER, 10, 10), makeRange(READ_HOLD_REGISTER, 0, 10)}, batch);
+    TEST_ASSERT_EQUAL_size_t(2, batch.size());
+    TEST_ASSERT_EQUAL_UINT8(READ_HOLD_REGISTER, batch[0].functionCode); //sorted by function code, then address
+    TEST_ASSERT_EQUAL_UINT16(0, batch[0].address);
+    TEST_ASSERT_EQUAL_UINT16(20, batch[0].count);
+    TEST_ASSERT_EQUAL_UINT8(READ_INPUT_REGISTER, batch[1].functionCode);
+    TEST_ASSERT_EQUAL_UINT16(20, batch[1].offset);
+    TEST_ASSERT_EQUAL_UINT16(30, cacheSize);
+}
+
+void test_split_above_max_register()
+{
+    std::vector<Talis5::poll_range_t> batch;
+    uint16_t cacheSize = Talis5Policy::mergeRange({makeRange(READ_HOLD_REGISTER, 0, 100), makeRange(READ_HOLD_REGISTER, 100, T5P_MAX_REGISTER - 100), makeRange(READ_HOLD_REGISTER, T5P_MAX_REGISTER, 1)}, batch);
+    TEST_ASSERT_EQUAL_size_t(2, batch.size());
+    TEST_ASSERT_EQUAL_UINT16(T5P_MAX_REGISTER, batch[0].count);
+    TEST_ASSERT_EQUAL_UINT16(T5P_MAX_REGISTER, batch[1].address);
+    TEST_ASSERT_EQUAL_UINT16(T5P_MAX_REGISTER, batch[1].offset);
+    TEST_ASSERT_EQUAL_UINT16(T5P_MAX_REGISTER + 1, cacheSize);
+}
+
+void test_first_response_set_timeout()
+{
+    Talis5::slave_state_t slave;
+    TEST_ASSERT_EQUAL_UINT32(T5P_MAX_TIMEOUT, slave.timeout); //before the first response
+    TEST_ASSERT_FALSE(Talis5Policy::recordSuccess(slave, 100));
+    TEST_ASSERT_EQUAL_UINT32(100, slave.averageTime);
+    TEST_ASSERT_EQUAL_UINT32(100 * 3 + T5P_TIMEOUT_MARGIN, slave.timeout);
+}
+
+void test_timeout_follow_average()
+{
+    Talis5::slave_state_t slave;
+    Talis5Policy::recordSuccess(slave, 100);
+    Talis5Policy::recordSuccess(slave, 180);
+    TEST_ASSERT_EQUAL_UINT32((100 * 7 + 180) / 8, slave.averageTime);
+    TEST_ASSERT_EQUAL_UINT32(110 * 3 + T5P_TIMEOUT_MARGIN, slave.timeout);
+}
+
+void test_timeout_is_clamped()
+{
+    Talis5::slave_state_t fast;
+    Talis5Policy::recordSuccess(fast, 5);
+    TEST_ASSERT_EQUAL_UINT32(T5P_MIN_TIMEOUT, fast.timeout);
+
+    Talis5::slave_state_t slow;
+    Talis5Policy::recordSuccess(slow, 400);
+    TEST_ASSERT_EQUAL_UINT32(T5P_MAX_TIMEOUT, slow.timeout);
+}
+
+void test_timeout_is_widened_on_timeout_only()
+{
+    Talis5::slave_state_t slave;
+    Talis5Policy::recordSuccess(slave, 100);
+    Talis5Policy::recordFailure(slave, CRC_ERROR, 0);
+    TEST_ASSERT_EQUAL_UINT32(320, slave.timeout);
+    Talis5Policy::recordFailure(slave, TIMEOUT, 0);
+    TEST_ASSERT_EQUAL_UINT32(640, slave.timeout);
+    Talis5Policy::recordSuccess(slave, 100);
+    Talis5Policy::recordFailure(slave, TIMEOUT, 0);
+    Talis5Policy::recordFailure(slave, TIMEOUT, 0);
+    TEST_ASSERT_EQUAL_UINT32(T5P_MAX_TIMEOUT, slave.timeout);
+}
+
+void test_offline_after_dead_count()
+{
+    Talis5::slave_state_t slave;
+    for (uint8_t i = 1; i < T5P_DEAD_COUNT; i++)
+    {
+        TEST_ASSERT_FALSE(Talis5Policy::recordFailure(slave, TIMEOUT, 5000));
+        TEST_ASSERT_TRUE(slave.isOnline);
+    }
+    TEST_ASSERT_TRUE(Talis5Policy::recordFailure(slave, TIMEOUT, 5000));
+    TEST_ASSERT_FALSE(slave.isOnline);
+    TEST_ASSERT_EQUAL_UINT32(T5P_MIN_BACKOFF, slave.backoff);
+    TEST_ASSERT_EQUAL_UINT32(5000 + T5P_MIN_BACKOFF, slave.skipUntil);
+    TEST_ASSERT_EQUAL_UINT32(T5P_DEAD_COUNT, slave.error);
+}
+
+void test_backoff_double_until_max()
+{
+    Talis5::slave_state_t slave;
+    for (uint8_t i = 0; i < T5P_DEAD_COUNT; i++)
+    {
+        Talis5Policy::recordFailure(slave, CRC_ERROR, 0);
+    }
+    uint32_t expected = T5P_MIN_BACKOFF;
+    while (expected < T5P_MAX_BACKOFF)
+    {
+        TEST_ASSERT_EQUAL_UINT32(expected, slave.backoff);
+        TEST_ASSERT_FALSE(Talis5Policy::recordFailure(slave, CRC_ERROR, 0)); //already offline
+        expected = expected * 2 > T5P_MAX_BACKOFF ? T5P_MAX_BACKOFF : expected * 2;
+    }
+    TEST_ASSERT_EQUAL_UINT32(T5P_MAX_BACKOFF, slave.backoff);
+    Talis5Policy::recordFailure(slave, CRC_ERROR, 0);
+    TEST_ASSERT_EQUAL_UINT32(T5P_MAX_BACKOFF, slave.backoff);
+}
+
+void test_recover_on_success()
+{
+    Talis5::slave_state_t slave;
+    for (uint8_t i = 0; i < T5P_DEAD_COUNT; i++)
+    {
+        Talis5Policy::recordFailure(slave, TIMEOUT, 0);
+    }
+    TEST_ASSERT_TRUE(Talis5Policy::recordSuccess(slave, 60));
+    TEST_ASSERT_TRUE(slave.isOnline);
+    TEST_ASSERT_EQUAL_UINT8(0, slave.failCount);
+    TEST_ASSERT_EQUAL_UINT32(0, slave.backoff);
+    TEST_ASSERT_EQUAL_UINT32(60 * 3 + T5P_TIMEOUT_MARGIN, slave.timeout);
+}
+
+void test_exception_reply_keep_slave_online()
+{
+    Talis5::slave_state_t slave;
+    Talis5Policy::recordSuccess(slave, 100);
+    Talis5Policy::recordFailure(slave, TIMEOUT, 0);
+    for (uint8_t i = 0; i < T5P_DEAD_COUNT * 2; i++)
+    {
+        TEST_ASSERT_FALSE(Talis5Policy::recordFailure(slave, ILLEGAL_DATA_ADDRESS, 0));
+    }
+    TEST_ASSERT_TRUE(slave.isOnline);
+    TEST_ASSERT_EQUAL_UINT8(0, slave.failCount); //exception reply proves the slave is alive
+    TEST_ASSERT_EQUAL_UINT32(640, slave.timeout); //widened by the timeout only
+    TEST_ASSERT_EQUAL_UINT32(1 + T5P_DEAD_COUNT * 2, slave.error);
+}
+
+void test_exception_reply_bring_slave_online()
+{
+    Talis5::slave_state_t slave;
+    for (uint8_t i = 0; i < T5P_DEAD_COUNT; i++)
+    {
+        Talis5Policy::recordFailure(slave, CRC_ERROR, 0);
+    }
+    TEST_ASSERT_FALSE(slave.isOnline);
+    Talis5Policy::recordFailure(slave, SERVER_DEVICE_BUSY, 0);
+    TEST_ASSERT_TRUE(slave.isOnline);
+    TEST_ASSERT_EQUAL_UINT32(0, slave.backoff);
+}
+
+void test_full_queue_is_not_counted()
+{
+    Talis5::slave_state_t slave;
+    for (uint8_t i = 0; i < T5P_DEAD_COUNT; i++)
+    {
+        TEST_ASSERT_FALSE(Talis5Policy::recordFailure(slave, REQUEST_QUEUE_FULL, 0));
+    }
+    TEST_ASSERT_TRUE(slave.isOnline);
+    TEST_ASSERT_EQUAL_UINT8(0, slave.failCount);
+}
+
+//only the error mapping of the gateway is tested natively, forward through ModbusClientRTU and the TCP server
+//(queue depth, busy reply, transaction id of pipelined request) is verified on the board
+void test_gateway_pass_slave_response()
+{
+    TEST_ASSERT_EQUAL_UINT8(SUCCESS, Talis5Policy::toGatewayError(SUCCESS));
+    TEST_ASSERT_EQUAL_UINT8(ILLEGAL_DATA_ADDRESS, Talis5Policy::toGatewayError(ILLEGAL_DATA_ADDRESS));
+    TEST_ASSERT_EQUAL_UINT8(SERVER_DEVICE_BUSY, Talis5Policy::toGatewayError(SERVER_DEVICE_BUSY));
+}
+
+void test_gateway_map_client_error()
+{
+    const Error clientError[] = {TIMEOUT, CRC_ERROR, FC_MISMATCH, SERVER_ID_MISMATCH, PACKET_LENGTH_ERROR, UNDEFINED_ERROR};
+    for (Error err : clientError)
+    {
+        TEST_ASSERT_EQUAL_UINT8(GATEWAY_TARGET_NO_RESP, Talis5Policy::toGatewayError(err));
+    }
+    TEST_ASSERT_EQUAL_UINT8(SERVER_DEVICE_BUSY, Talis5Policy::toGatewayError(REQUEST_QUEUE_FULL));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_merge_contiguous_range);
+    RUN_TEST(test_never_merge_across_gap);
+    RUN_TEST(test_merge_overlapping_range);
+    RUN_TEST(test_never_merge_function_code);
+    RUN_TEST(test_split_above_max_register);
+    RUN_TEST(test_first_response_set_timeout);
+    RUN_TEST(test_timeout_follow_average);
+    RUN_TEST(test_timeout_is_clamped);
+    RUN_TEST(test_timeout_is_widened_on_timeout_only);
+    RUN_TEST(test_offline_after_dead_count);
+    RUN_TEST(test_backoff_double_until_max);
+    RUN_TEST(test_recover_on_success);
+    RUN_TEST(test_exception_reply_keep_slave_online);
+    RUN_TEST(test_exception_reply_bring_slave_online);
+    RUN_TEST(test_full_queue_is_not_counted);
+    RUN_TEST(test_gateway_pass_slave_response);
+    RUN_TEST(test_gateway_map_client_error);
+    return UNITY_END();
+}
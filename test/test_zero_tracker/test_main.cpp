@@ -0,0 +1,131 @@
+#include <unity.h>
+#include <ZeroTracker.h>
+
+static CC6940Config config;
+
+/**
+ * Open the relay feedback and wait the settle time
+ *
+ * @param[in]   tracker tracker to open
+ * @param[in]   adcInMillivolts sample used while settling
+ */
+static void openAndSettle(ZeroTracker &tracker, uint32_t adcInMillivolts)
+{
+    tracker.update(adcInMillivolts, true);
+    Stub::now += ZT_SETTLE_TIME * 1000ULL;
+}
+
+void setUp()
+{
+    Stub::now = 5000000;
+    config = CC6940Config();
+}
+
+void tearDown()
+{
+}
+
+void test_sample_inside_settle_time_is_ignored()
+{
+    ZeroTracker tracker;
+    tracker.begin(config);
+    TEST_ASSERT_FALSE(tracker.update(config.midPoint + 10, true));
+    Stub::now += (ZT_SETTLE_TIME - 1) * 1000ULL;
+    TEST_ASSERT_FALSE(tracker.update(config.midPoint + 10, true));
+    Stub::now += 1000;
+    TEST_ASSERT_TRUE(tracker.update(config.midPoint + 10, true));
+    TEST_ASSERT_EQUAL_UINT32(1, tracker.getAccepted());
+    TEST_ASSERT_EQUAL_UINT32(0, tracker.getRejected());
+}
+
+void test_closed_relay_restart_settle_time()
+{
+    ZeroTracker tracker;
+    tracker.begin(config);
+    openAndSettle(tracker, config.midPoint);
+    TEST_ASSERT_TRUE(tracker.update(config.midPoint, true));
+    TEST_ASSERT_FALSE(tracker.update(config.midPoint, false));
+    TEST_ASSERT_FALSE(tracker.update(config.midPoint, true)); //settle again after every close
+    TEST_ASSERT_EQUAL_UINT32(1, tracker.getAccepted());
+}
+
+void test_outlier_is_rejected()
+{
+    ZeroTracker tracker;
+    tracker.begin(config);
+    openAndSettle(tracker, config.midPoint);
+    TEST_ASSERT_TRUE(tracker.update(config.midPoint + ZT_OUTLIER, true));
+    TEST_ASSERT_FALSE(tracker.update(config.midPoint + ZT_OUTLIER + 1, true));
+    TEST_ASSERT_FALSE(tracker.update(config.midPoint - ZT_OUTLIER - 1, true));
+    TEST_ASSERT_EQUAL_UINT32(1, tracker.getAccepted());
+    TEST_ASSERT_EQUAL_UINT32(2, tracker.getRejected());
+    TEST_ASSERT_EQUAL_INT32(0, tracker.getOffset());
+}
+
+void test_offset_is_clamped()
+{
+    config.offset = ZT_MAX_OFFSET - 10;
+    ZeroTracker tracker;
+    tracker.begin(config);
+    openAndSettle(tracker, config.midPoint);
+    for (uint32_t i = 0; i < 20000; i++)
+    {
+        tracker.update(config.midPoint + ZT_MAX_OFFSET + 15, true); //inside the outlier window of the estimate
+    }
+    TEST_ASSERT_EQUAL_UINT32(20000, tracker.getAccepted());
+    TEST_ASSERT_EQUAL_INT32(ZT_MAX_OFFSET, tracker.getOffset());
+
+    config.offset = -ZT_MAX_OFFSET + 10;
+    tracker.begin(config);
+    openAndSettle(tracker, config.midPoint);
+    for (uint32_t i = 0; i < 20000; i++)
+    {
+        tracker.update(config.midPoint - ZT_MAX_OFFSET - 15, true);
+    }
+    TEST_ASSERT_EQUAL_INT32(-ZT_MAX_OFFSET, tracker.getOffset());
+}
+
+void test_converge_and_round_negative_offset()
+{
+    ZeroTracker tracker;
+    tracker.begin(config);
+    openAndSettle(tracker, config.midPoint);
+    tracker.update(config.midPoint - 3, true);
+    TEST_ASSERT_EQUAL_INT32(0, tracker.getOffset()); //one sample move the estimate by 1 / 2^ZT_FILTER_SHIFT only
+    for (uint32_t i = 0; i < 20000; i++)
+    {
+        tracker.update(config.midPoint - 3, true);
+    }
+    TEST_ASSERT_EQUAL_INT32(-3, tracker.getOffset());
+}
+
+void test_fraction_bits()
+{
+    config.offset = 10;
+    ZeroTracker tracker;
+    tracker.begin(config);
+    openAndSettle(tracker, config.midPoint);
+    TEST_ASSERT_TRUE(tracker.update((config.midPoint + 10) << 2, true, 2));
+    TEST_ASSERT_TRUE(tracker.update((config.midPoint + 10) << ZT_FRACTION, true, ZT_FRACTION));
+    TEST_ASSERT_EQUAL_INT32(10, tracker.getOffset());
+    TEST_ASSERT_FALSE(tracker.update(config.midPoint + 10, true, ZT_FRACTION + 1));
+    TEST_ASSERT_EQUAL_UINT32(2, tracker.getAccepted());
+
+    for (uint32_t i = 0; i < 20000; i++)
+    {
+        tracker.update(((config.midPoint + 12) << 4) + 8, true, 4); //12.5 mV
+    }
+    TEST_ASSERT_EQUAL_INT32(12, tracker.getOffset()); //estimate stay just below 12.5 mV
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_sample_inside_settle_time_is_ignored);
+    RUN_TEST(test_closed_relay_restart_settle_time);
+    RUN_TEST(test_outlier_is_rejected);
+    RUN_TEST(test_offset_is_clamped);
+    RUN_TEST(test_converge_and_round_negative_offset);
+    RUN_TEST(test_fraction_bits);
+    return UNITY_END();
+}